@@ -14,7 +14,7 @@ class ChartWidget : public QWidget
 public:
     explicit ChartWidget(QWidget *parent = nullptr);
 
-    void createXY(const std::vector<std::unique_ptr<GRNode> > &nodes);
-    void createZX(const std::vector<std::unique_ptr<GRNode>> &nodes);
+    void createXY(const std::vector<GRNode *> &nodes);
+    void createZX(const std::vector<GRNode *> &nodes);
 };
 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <limits>
+#include <vector>
+
+/*
+ * Column-oriented view of a CSV file.
+ *
+ * The file is memory-mapped and parsed in a single pass into one contiguous
+ * array of doubles per column. Cells that do not hold a number (e.g. the
+ * header line) are stored as NaN. Cell text is never copied; it is decoded
+ * from the mapping on request, which is only needed for displaying the table.
+ */
+class CSVTable
+{
+public:
+    CSVTable() = default;
+    ~CSVTable() { close(); }
+
+    CSVTable(const CSVTable &) = delete;
+    CSVTable &operator=(const CSVTable &) = delete;
+
+    bool open(const QString &path, QString *error = nullptr);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    QString path() const { return file.fileName(); }
+
+    int rowCount() const { return rows; }
+    int columnCount() const { return static_cast<int>(columns.size()); }
+
+    // NaN outside the table, like cells that do not hold a number
+    double value(int row, int column) const {
+        if (row < 0 || row >= rows || column < 0 || column >= columnCount()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return columns[column][row];
+    }
+    const double *column(int column) const { return columns[column].data(); }
+
+    QString text(int row, int column) const;
+
+private:
+    QFile file;
+    const char *data = nullptr;
+    qint64 size = 0;
+
+    int rows = 0;
+
+    // offset of the first byte of each row, plus one past the last row
+    std::vector<qint64> rowOffsets;
+    std::vector<std::vector<double>> columns;
+
+    void parse();
+};
@@ -1,19 +1,82 @@
 #pragma once
 
-#include "detectionevent.h"
+#include "eventfile.h"
+#include "hitindex.h"
 
 #include <QFile>
 #include <QString>
 
+#include <cstdint>
+#include <vector>
 
+/*
+ * Reader for a file of detection events, either JSON or a binary EventFile.
+ *
+ * A JSON file is memory-mapped and scanned once for the byte range and the
+ * id of every entry of "Events", without building a document. Events are
+ * only decoded, one at a time, when they are asked for, so files far larger
+ * than what fits into memory as a QJsonDocument can be opened. A binary file
+ * is mapped and its events are copied out of the tables without parsing.
+ */
 class DetectionEventReader
 {
 public:
-    DetectionEventReader(const QString &file);
+    DetectionEventReader() = default;
+    ~DetectionEventReader() { close(); }
 
-    QVector<DetectionEvent> parseEvents(bool *success);
+    DetectionEventReader(const DetectionEventReader &) = delete;
+    DetectionEventReader &operator=(const DetectionEventReader &) = delete;
+
+    bool open(const QString &path, QString *error = nullptr);
+    void close();
+
+    // one decoded event, the hits of trajectory i are hits[offsets[i]] up
+    // to hits[offsets[i + 1]]
+    struct Event {
+        int id = -1;
+        std::vector<std::int32_t> trajectoryIds;
+        std::vector<std::uint64_t> offsets;
+        std::vector<std::int32_t> hits;
+        // per hit, NaN for hits without one; empty if no hit has a timestamp
+        std::vector<double> times;
+
+        // per hit, the node index filled in by resolve, -1 for unknown hits
+        std::vector<std::int32_t> indices;
+        int unknownHits = 0;
+
+        int trajectoryCount() const { return static_cast<int>(trajectoryIds.size()); }
+
+        // see resolveHits
+        template<typename IndexOf>
+        void resolve(IndexOf indexOf) { unknownHits = resolveHits(hits, indices, indexOf); }
+    };
+
+    int eventCount() const {
+        return binary.isOpen() ? binary.eventCount() : static_cast<int>(entries.size());
+    }
+    int eventId(int event) const {
+        return binary.isOpen() ? binary.eventIds()[event] : entries[event].id;
+    }
+
+    // decodes the event into out, reusing its storage
+    bool readEvent(int event, Event *out) const;
 
 private:
+    struct Entry {
+        qint64 begin;
+        qint64 end;
+        int id;
+    };
+
+    // the JSON file
     QFile file;
-};
+    const char *data = nullptr;
+    qint64 size = 0;
 
+    std::vector<Entry> entries;
+
+    EventFile binary;
+
+    bool index(QString *error);
+    bool readJsonEvent(int event, Event *out) const;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "nodelayer.h"
+#include "rendermodel.h"
+
+#include <QGraphicsItem>
+
+/*
+ * Draws the shown direct edges of a scene as a single item.
+ *
+ * The edges are those of the RenderModel, pairs of node indices into the
+ * NodeLayer, whose node centers are the vertices of the lines. Only the
+ * edges that are shown are drawn, all of them with one drawLines call.
+ */
+class EdgeLayer : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 4 };
+    EdgeLayer(const RenderModel *render, const NodeLayer *nodes, QGraphicsItem *parent = nullptr);
+
+    int type() const override { return Type; }
+    QRectF boundingRect() const override { return bounds; }
+
+    // grows the bounds by the edges from first on
+    void include(int first);
+    void clear();
+
+protected:
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+private:
+    const RenderModel *render;
+    const NodeLayer *nodes;
+
+    QRectF bounds;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <cstdint>
+
+class DetectionEventReader;
+
+/*
+ * Binary event file, the tables of a set of detection events stored so that
+ * they can be mapped and used without parsing.
+ *
+ * Layout, in native byte order, every array starting at a multiple of 8:
+ *     Header
+ *     std::int32_t  eventIds[eventCount]
+ *     std::uint64_t eventOffsets[eventCount + 1]          (into the trajectories)
+ *     std::int32_t  trajectoryIds[trajectoryCount]
+ *     std::uint64_t trajectoryOffsets[trajectoryCount + 1] (into the hits)
+ *     std::int32_t  hits[hitCount]                        (hit ids)
+ *     double        times[hitCount]                       (with HasTimes only)
+ *
+ * The trajectories of event e are eventOffsets[e] up to eventOffsets[e + 1],
+ * the hits of trajectory t are trajectoryOffsets[t] up to
+ * trajectoryOffsets[t + 1]. Hits without a timestamp have a time of NaN.
+ */
+class EventFile
+{
+public:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint64_t eventCount;
+        std::uint64_t trajectoryCount;
+        std::uint64_t hitCount;
+    };
+
+    static constexpr char magic[8] = {'S', 'T', 'T', '2', 'N', 'G', 'E', '\0'};
+    static constexpr std::uint32_t version = 1;
+
+    enum Flags : std::uint32_t {
+        HasTimes = 1 << 0
+    };
+
+    static std::uint64_t align(std::uint64_t size) { return (size + 7) & ~std::uint64_t(7); }
+
+    // byte offsets of the arrays in a file with the given header
+    static std::uint64_t eventIdsOffset() { return align(sizeof(Header)); }
+    static std::uint64_t eventOffsetsOffset(const Header &header) {
+        return eventIdsOffset() + align(header.eventCount * sizeof(std::int32_t));
+    }
+    static std::uint64_t trajectoryIdsOffset(const Header &header) {
+        return eventOffsetsOffset(header) + (header.eventCount + 1) * sizeof(std::uint64_t);
+    }
+    static std::uint64_t trajectoryOffsetsOffset(const Header &header) {
+        return trajectoryIdsOffset(header) + align(header.trajectoryCount * sizeof(std::int32_t));
+    }
+    static std::uint64_t hitsOffset(const Header &header) {
+        return trajectoryOffsetsOffset(header) + (header.trajectoryCount + 1) * sizeof(std::uint64_t);
+    }
+    static std::uint64_t timesOffset(const Header &header) {
+        return hitsOffset(header) + align(header.hitCount * sizeof(std::int32_t));
+    }
+    static std::uint64_t fileSize(const Header &header) {
+        return timesOffset(header) + (header.flags & HasTimes ? header.hitCount * sizeof(double) : 0);
+    }
+
+    // whether the file at path starts like an event file
+    static bool isEventFile(const QString &path);
+
+    // writes all events of the reader to path
+    static bool convert(const DetectionEventReader &reader, const QString &path, QString *error = nullptr);
+
+    EventFile() = default;
+    ~EventFile() { close(); }
+
+    EventFile(const EventFile &) = delete;
+    EventFile &operator=(const EventFile &) = delete;
+
+    // maps the file and checks that its header and offsets are consistent
+    bool open(const QString &path, QString *error = nullptr);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+
+    int eventCount() const { return static_cast<int>(header.eventCount); }
+    std::uint64_t trajectoryCount() const { return header.trajectoryCount; }
+    std::uint64_t hitCount() const { return header.hitCount; }
+    bool hasTimes() const { return header.flags & HasTimes; }
+
+    const std::int32_t *eventIds() const { return eventIdArray; }
+    const std::uint64_t *eventOffsets() const { return eventOffsetArray; }
+    const std::int32_t *trajectoryIds() const { return trajectoryIdArray; }
+    const std::uint64_t *trajectoryOffsets() const { return trajectoryOffsetArray; }
+    const std::int32_t *hits() const { return hitArray; }
+    // nullptr without timestamps
+    const double *times() const { return timeArray; }
+
+private:
+    QFile file;
+    uchar *data = nullptr;
+
+    Header header {};
+    const std::int32_t *eventIdArray = nullptr;
+    const std::uint64_t *eventOffsetArray = nullptr;
+    const std::int32_t *trajectoryIdArray = nullptr;
+    const std::uint64_t *trajectoryOffsetArray = nullptr;
+    const std::int32_t *hitArray = nullptr;
+    const double *timeArray = nullptr;
+};
@@ -16,6 +16,15 @@ public:
         Compound
     };
 
+    // Values of one field for every row: either a column of the CSV table,
+    // or the same fixed value for each row.
+    struct Span {
+        const double *data = nullptr;
+        double value = 0;
+
+        double operator[](int row) const { return data ? data[row] : value; }
+    };
+
     GeometryParameter(const QString &name, const QVector<QString> &fieldNames, ParameterModel *context, bool isColumnValue = false);
 
     double getFieldValue(const QString &field = nullptr) const;
@@ -35,6 +44,10 @@ public:
     GRVector3 toGRVector3(int row);
     GRVector2 toGRVector2(int row);
 
+    // unlike the accessors above, which read cells without a number as 0,
+    // a span passes on their NaN so that callers can skip such rows
+    Span toSpan(const QString &field = nullptr) const;
+
 signals:
     void valueChanged(QString field, double value);
     void columnValueChanged(bool isColumn);
@@ -47,5 +60,7 @@ private:
     bool columnar = false;
 
     QMap<QString, double> fields;
+
+    double cellValue(int row, double column) const;
 };
 
@@ -1,36 +1,92 @@
 #pragma once
 
 #include <GRNode>
-#include <GRBuilder>
+#include <QFutureWatcher>
 #include <QObject>
 #include <memory>
 
+#include "relation.h"
+#include "relationbuilder.h"
+
 class GraphModel;
+class NodeArena;
 
+/*
+ * Builds the neighbourhood relation of the model's nodes on a worker thread.
+ *
+ * build() returns immediately; progress is reported through progressChanged
+ * and the edges are added to the model on the GUI thread once the relation
+ * is complete, a batch of rows per event loop iteration. Cancelling before
+ * then leaves the model untouched. Cancelling while the batches are added
+ * removes all edges of the model, so that no partial relation is left; the
+ * edges of an earlier build are not restored.
+ *
+ * As long as the nodes do not change, rebuilding with another order or
+ * tolerance reuses the first-order pairs of the previous build (see
+ * RelationBuilder).
+ */
 class GraphBuilder : public QObject
 {
     Q_OBJECT
     using GRNode = GeomRel::GRNode;
-    using GRBuilder = GeomRel::GRBuilder;
 public:
     GraphBuilder(GraphModel *model, QObject *parent = nullptr);
-    virtual ~GraphBuilder() {};
+    virtual ~GraphBuilder();
+
+    void build(int order, double tolerance);
+    void cancel();
+    bool isBuilding() const { return building; }
 
-    void build(int order, double tolerance, std::function<void(void)> progressCallback = [](){});
     void clearAll();
     void clearNodes();
     void clearEdges();
 
     int getNodeCount();
 
-    void addNodes(std::vector<std::unique_ptr<GRNode> > nodes);
+    // 0 uses one thread per hardware core; the default of 1 without the grid
+    // builds in a single GRBuilder pass. Both take effect with the next build.
+    void setThreadCount(int count) { threads = count; }
+    int threadCount() const { return threads; }
+
+    void setUseSpatialGrid(bool use) { useGrid = use; }
+    bool usesSpatialGrid() const { return useGrid; }
+
+    // both return the number of nodes the model rejected, see GraphModel
+    int addNodes(std::unique_ptr<NodeArena> nodes);
+    // Replaces the nodes like addNodes, but the next build only tests the
+    // nodes that are new or have moved, keeping the pairs of the others.
+    int updateNodes(std::unique_ptr<NodeArena> nodes);
 
 signals:
+    // emitted from the worker thread while the relation is built
+    void progressChanged(int value, int maximum);
     void buildCompleted();
+    void buildCancelled();
 
 private:
     GraphModel *model;
 
-    GRBuilder builder;
-};
+    RelationBuilder builder;
+    QFutureWatcher<void> watcher;
 
+    // handed to the builder when a build starts, never while it runs
+    int threads = 1;
+    bool useGrid = false;
+
+    bool building = false;
+    bool cancelled = false;
+    // counts builds, so that queued batches of an earlier build are dropped
+    int generation = 0;
+
+    // the builder keeps the pairs of its last build until it gets new nodes
+    bool nodesChanged = true;
+
+    // written by the worker, read on the GUI thread once it has finished
+    Relation relation;
+    int nextRow = 0;
+
+    void relationFinished();
+    void addEdgeBatch();
+    void finishBuild();
+    void waitForBuild();
+};
@@ -1,42 +1,79 @@
 #pragma once
 
-#include <map>
 #include <memory>
+#include <vector>
 
 #include <GRNode>
 #include <QObject>
 
+#include "idtable.h"
+#include "nodearena.h"
+#include "relation.h"
+
+/*
+ * Nodes and edges of the neighbourhood graph.
+ *
+ * Nodes are kept in one contiguous array; the position of a node in it is
+ * its index, which stays valid until all nodes are removed and is used by
+ * the scenes as a handle. Removing a single node leaves an empty slot.
+ * Ids must be unique and must not be -1, which stands for no node; nodes
+ * that break this are not added. Edges are stored in a flat list, from which a CSR relation with one
+ * row per index is built when it is next asked for.
+ */
 class GraphModel : public QObject {
     Q_OBJECT
     using GRNode = GeomRel::GRNode;
 public:
+    struct Edge {
+        int from;
+        int to;
+        int order;
+    };
+
     explicit GraphModel() {}
     virtual ~GraphModel() {}
 
-    void addNode(std::unique_ptr<GRNode> node);
+    // false if the node was not added, see above
+    bool addNode(std::unique_ptr<GRNode> node);
+    // number of nodes of the arena that were not added
+    int addNodes(std::unique_ptr<NodeArena> arena);
     void addEdge(int from_id, int to_id, int order);
+    // adds all edges, then emits a single edgesAdded for those that were added
+    void addEdges(const std::vector<Edge> &edges);
 
     void removeNode(int id);
 
     void removeAllNodes();
     void removeAllEdges();
 
-    std::vector<GRNode *> getNodes() {
+    std::vector<GRNode *> getNodes() const {
         std::vector<GRNode *> vec;
-        for (auto &[id, node] : nodes) {
-            vec.push_back(node.get());
+        vec.reserve(nodeCount);
+        for (auto node : nodes) {
+            if (node) vec.push_back(node);
         }
         return vec;
     }
 
-    GRNode *getNode(int id) {
-        auto it = nodes.find(id);
-        if (it != nodes.end()) {
-            return it->second.get();
-        }
-        return nullptr;
+    int getNodeCount() const { return nodeCount; }
+
+    // -1 if there is no node with this id
+    int indexOf(int id) const { return indices.find(id); }
+
+    // number of indices in use, including those of removed nodes
+    int indexCount() const { return static_cast<int>(nodes.size()); }
+
+    // nullptr if the node at this index was removed
+    GRNode *nodeAt(int index) const { return nodes[index]; }
+
+    GRNode *getNode(int id) const {
+        const int index = indexOf(id);
+        return index >= 0 ? nodes[index] : nullptr;
     }
 
+    // one row per index, rows of removed nodes have id -1 and no neighbours
+    const Relation &getRelation();
+
     void selectNode(int id) {
         if (selectedNode != id){
             selectedNode = id;
@@ -54,16 +91,32 @@ public:
 signals:
     void nodeAdded(GRNode *node);
     void edgeAdded(GRNode *from, GRNode *to, int order);
+    void edgesAdded(const std::vector<GraphModel::Edge> &edges);
 
     void nodeRemoved(GRNode *node);
     void edgeRemoved(GRNode *from, GRNode *to);
+    void allNodesRemoved();
+    void allEdgesRemoved();
 
     void nodeSelected(int id, bool selected);
 
 private:
-    std::map<int, int> ids;
-    std::map<int, std::unique_ptr<GRNode>> nodes;
-    std::map<int, std::set<int>> edges;
+    // node index by id
+    IdTable indices;
+    std::vector<GRNode *> nodes;
+    int nodeCount = 0;
+
+    // edges by node index, each pair stored once
+    std::vector<Edge> edges;
+
+    Relation relation;
+    bool relationValid = false;
+
+    // storage of the nodes, either allocated in bulk or added one by one
+    std::vector<std::unique_ptr<NodeArena>> arenas;
+    std::vector<std::unique_ptr<GRNode>> ownedNodes;
 
     int selectedNode = -1;
+
+    bool insertNode(GRNode *node);
 };
@@ -1,15 +1,16 @@
 #pragma once
 
-#include "visualgraphnode.h"
-#include "visualgraphedge.h"
-#include "trajectory.h"
-#include "detectionevent.h"
-#include "graphmodel.h"
+#include "nodelayer.h"
+#include "edgelayer.h"
+#include "rendermodel.h"
 
-#include <QGraphicsDropShadowEffect>
 #include <QGraphicsScene>
-#include <QMap>
 
+/*
+ * One projection of the graph. Nodes and edges, their colours and the
+ * selection live in the shared RenderModel; the scene only keeps the
+ * projected ellipses of the nodes.
+ */
 class GraphScene : public QGraphicsScene
 {
     Q_OBJECT
@@ -17,16 +18,17 @@ class GraphScene : public QGraphicsScene
 public:
     enum class Axes : int {
         XY,
-        XZ
+        XZ,
+        YZ,
+        // arc length r * phi against r, tubes of a layer keep their spacing
+        RPhi
     };
 
-    explicit GraphScene(GraphModel *model, Axes axes = Axes::XY, QObject *parent = nullptr);
+    explicit GraphScene(RenderModel *render, Axes axes = Axes::XY, QObject *parent = nullptr);
     ~GraphScene() {};
 
-    void showDetection(const DetectionEvent &event);
-    void hideDetection(const DetectionEvent &event);
-
-    void drawTrajectory(const Trajectory &trajectory, QColor color, double scale);
+    // the unscaled ellipse of the node in this projection
+    static QRectF project(const GRNode *node, Axes axes);
 
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent) override;
@@ -34,27 +36,27 @@ protected:
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent) override;
 
 private slots:
-    void createVisualNode(GRNode *node);
-    void removeVisualNode(GRNode *node);
+    void createVisualNode(int index);
+    void removeVisualNode(int index);
+    void removeAllVisualNodes();
+
+    void createVisualEdges(int first);
+    void removeAllVisualEdges();
 
-    void createVisualEdge(GRNode *from, GRNode *to, int order);
-    void removeVisualEdge(GRNode *from, GRNode *to);
+    void updateStyle();
 
 private:
-    bool leftButtonDown;
-    QPointF startPoint;
     QGraphicsLineItem *line;
 
+    RenderModel *render;
     GraphModel *model;
 
-    std::map<int, VisualGraphNode *> v_nodes;
-    std::vector<VisualGraphEdge *> v_edges;
+    // all nodes, by their index in the model, and the direct edges between them
+    NodeLayer *nodes;
+    EdgeLayer *edges;
 
     Axes axes;
 
-    int currentSelection = -1;
-
-    void showNeighbours(VisualGraphNode *v_node);
-    void hideNeighbours(VisualGraphNode *v_node);
+    // id of the node at pos, -1 if there is none
+    int nodeAt(const QPointF &pos) const;
 };
-
@@ -4,12 +4,17 @@
 #include "graphview.h"
 #include "graphbuilder.h"
 #include "graphmodel.h"
+#include "rendermodel.h"
+#include "detectioneventreader.h"
+#include "trajectory.h"
 
 #include <QWidget>
 #include <QStandardItemModel>
 #include <QListView>
 #include <QTreeView>
 
+#include <memory>
+
 class GraphWidget : public QWidget
 {
 public:
@@ -19,6 +24,7 @@ public:
     void setBuilder(GraphBuilder *builder) { graphBuilder = builder; }
 
     GraphModel *getModel() const {return graphModel;}
+    RenderModel *getRenderModel() const { return renderModel; }
     std::vector<GraphScene *> &getScenes() {return scenes;}
     std::map<int, GraphView *> &getViews() {return views;}
 
@@ -26,8 +32,8 @@ public:
     GraphView *getView(int scene_id) {return views.at(scene_id);}
     GraphBuilder *getBuilder() { return graphBuilder; }
 
-    void addDetectionEvents(const QVector<DetectionEvent> &events);
-    void addDetectionEvent(const DetectionEvent &event);
+    // lists the events of the reader, which is kept until the set is removed
+    void addDetectionEvents(std::unique_ptr<DetectionEventReader> reader);
     void clearEvents();
 
 protected:
@@ -35,6 +41,7 @@ protected:
 
 private:
     GraphModel *graphModel;
+    RenderModel *renderModel;
 
     std::vector<GraphScene *> scenes;
     std::map<int, GraphView *> views;
@@ -45,7 +52,14 @@ private:
     QStandardItemModel *eventModel;
     QTreeView *eventView;
 
-    QStandardItem *eventToItem(const DetectionEvent &event);
+    // readers by event set, nullptr for removed sets
+    std::vector<std::unique_ptr<DetectionEventReader>> eventSets;
+
+    QStandardItem *eventItem(int set, int event, int id);
+    void decodeEvent(QStandardItem *item);
+    // the trajectory of the item, its hits resolved against the current graph
+    Trajectory trajectoryOf(QStandardItem *item);
+    void setTrajectoryText(QStandardItem *item, const Trajectory &trajectory);
 
     void setupEventList();
 
@@ -2,16 +2,74 @@
 
 #include <GeomRel>
 
+#include "relation.h"
+#include "relationfile.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * Writes a neighbourhood relation as CSV, or in the binary format read by
+ * RelationFile.
+ *
+ * The flat CSV layout has one row per node with its id followed by the ids
+ * of all its neighbours. The by-order layout has one row per node and order,
+ * "Id,Order,neighbours", holding only the neighbours of that order; nodes
+ * without neighbours have no row.
+ *
+ * Output is formatted into a large buffer that is written out in one call
+ * per chunk. Besides writing complete node lists or relations, rows can be
+ * streamed as they are built: beginCSV, writeRow for every row, endCSV.
+ */
 class GraphWriter
 {
     using GRNode = GeomRel::GRNode;
 public:
+    enum class Layout {
+        Flat,
+        ByOrder
+    };
+
+    GraphWriter() = default;
     GraphWriter(const std::vector<GRNode *> &nodes);
-    virtual ~GraphWriter() {}
+    GraphWriter(const Relation &relation);
+    virtual ~GraphWriter();
+
+    void setLayout(Layout layout) { this->layout = layout; }
+    Layout getLayout() const { return layout; }
+
+    // the relation held by the neighbour lists of the nodes
+    static Relation relationOf(const std::vector<GRNode *> &nodes);
 
     bool writeCSV(std::string path, std::string *error);
+    // see RelationFile for the layout
+    bool writeBinary(std::string path, std::string *error);
+
+    // neighbours of the streamed rows are given as indices into ids, and
+    // have to be sorted by order for the by-order layout
+    bool beginCSV(const std::string &path, const std::vector<std::int32_t> &ids, std::string *error);
+    void writeRow(int row, const std::int32_t *neighbours, const std::uint8_t *orders, std::size_t count);
+    bool endCSV(std::string *error);
 
 private:
     std::vector<GRNode *> nodes;
-};
+    const Relation *relation = nullptr;
+    Layout layout = Layout::Flat;
+
+    // streaming state
+    std::FILE *file = nullptr;
+    const std::vector<std::int32_t> *rowIds = nullptr;
+    std::vector<char> buffer;
+    std::size_t used = 0;
+    bool failed = false;
 
+    bool open(const std::string &path, std::string *error, bool header = true);
+    bool close(std::string *error);
+
+    void append(const char *text, std::size_t length);
+    void append(std::int64_t value);
+    void reserve(std::size_t length);
+    void flush();
+};
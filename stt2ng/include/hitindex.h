@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+ * Looks up the node index of every hit once, so that drawing and analysis
+ * work on indices. indexOf(id) returns -1 for ids without a node; indices is
+ * resized to the hits and the number of such hits is returned.
+ */
+template <typename Hits, typename Indices, typename IndexOf>
+int resolveHits(const Hits &hits, Indices &indices, IndexOf indexOf)
+{
+    indices.resize(hits.size());
+    int unknown = 0;
+    for (decltype(hits.size()) i = 0; i < hits.size(); ++i) {
+        indices[i] = indexOf(hits[i]);
+        if (indices[i] < 0) ++unknown;
+    }
+    return unknown;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Maps node ids to indices.
+ *
+ * Ids below a bound proportional to the number of entries are kept in a
+ * dense table, all others (negative or far beyond the rest) in a hash map,
+ * so memory stays linear in the number of ids whatever their values.
+ */
+class IdTable
+{
+public:
+    // -1 if the id is not in the table
+    int find(int id) const {
+        if (id >= 0 && id < static_cast<int>(dense.size()) && dense[id] >= 0) return dense[id];
+        if (sparse.empty()) return -1;
+
+        auto it = sparse.find(id);
+        return it != sparse.end() ? it->second : -1;
+    }
+
+    // false if the id is already in the table
+    bool insert(int id, int index) {
+        if (find(id) >= 0) return false;
+
+        if (id >= 0 && id < denseLimit()) {
+            if (id >= static_cast<int>(dense.size())) {
+                dense.resize(id + 1, -1);
+            }
+            dense[id] = index;
+        } else {
+            sparse[id] = index;
+        }
+        ++count;
+        return true;
+    }
+
+    void erase(int id) {
+        if (id >= 0 && id < static_cast<int>(dense.size()) && dense[id] >= 0) {
+            dense[id] = -1;
+            --count;
+        } else if (sparse.erase(id) > 0) {
+            --count;
+        }
+    }
+
+    void clear() {
+        dense.clear();
+        sparse.clear();
+        count = 0;
+    }
+
+    int size() const { return count; }
+
+private:
+    // the dense table never grows beyond a few entries per id in use
+    static constexpr std::int64_t minDenseSize = 1 << 16;
+    static constexpr std::int64_t densePerId = 4;
+
+    std::vector<int> dense;
+    std::unordered_map<int, int> sparse;
+    int count = 0;
+
+    int denseLimit() const {
+        const auto limit = std::max(minDenseSize, densePerId * (count + 1));
+        return static_cast<int>(std::min<std::int64_t>(limit, std::numeric_limits<int>::max()));
+    }
+};
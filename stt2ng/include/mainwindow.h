@@ -7,12 +7,14 @@
 #include <QStandardPaths>
 #include <QStandardItemModel>
 #include <QProgressBar>
+#include <QPushButton>
 #include <GRNode>
 
 #include "chartwidget.h"
 #include "csvparameterwidget.h"
 #include "graphwriter.h"
 #include "graphwidget.h"
+#include "nodearena.h"
 
 #ifdef ENABLE_3D
 #include "threedscene.h"
@@ -62,6 +64,10 @@ private slots:
 
     void on_relationOrderSpinBox_valueChanged(int value);
 
+    void on_actionParallel_Build_toggled(bool checked);
+
+    void on_actionSpatial_Grid_toggled(bool checked);
+
 private:
     Ui::MainWindow *ui;
 
@@ -79,12 +85,13 @@ private:
     QString lastExportPath = documentsPath;
 
     QProgressBar *progressBar;
+    QPushButton *cancelButton;
 
     void setupTableWidget();
     void setupGraphWidget();
     void setupChartWidget();
 
-    std::vector<std::unique_ptr<GeomRel::GRNode>> generateNodes();
+    std::unique_ptr<NodeArena> generateNodes();
 
 #ifdef ENABLE_3D
     ThreeDScene *scene;
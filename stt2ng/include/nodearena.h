@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GRCylinder>
+#include <GRNode>
+#include <GRVector>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Owns the cylinders of one geometry in a single contiguous allocation.
+ *
+ * Cylinders are constructed in place and destroyed together with the arena.
+ * nodes() is filled while the cylinders are added, so it can be handed to
+ * GRBuilder or GraphWriter without building a separate pointer list.
+ */
+class NodeArena
+{
+    using GRNode = GeomRel::GRNode;
+    using GRCylinder = GeomRel::GRCylinder;
+    using GRVector3 = GeomRel::GRVector3;
+public:
+    explicit NodeArena(size_t capacity);
+    ~NodeArena();
+
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    // returns nullptr if the arena is full
+    GRCylinder *addCylinder(int id, const GRVector3 &center, const GRVector3 &direction, double length, double radius);
+
+    size_t size() const { return count; }
+    size_t capacity() const { return cap; }
+    bool empty() const { return count == 0; }
+
+    GRCylinder &cylinder(size_t index) { return *std::launder(reinterpret_cast<GRCylinder *>(&storage[index])); }
+    const GRCylinder &cylinder(size_t index) const { return *std::launder(reinterpret_cast<const GRCylinder *>(&storage[index])); }
+
+    const std::vector<GRNode *> &nodes() const { return nodePtrs; }
+
+private:
+    using Storage = std::aligned_storage_t<sizeof(GRCylinder), alignof(GRCylinder)>;
+
+    std::unique_ptr<Storage[]> storage;
+    size_t cap;
+    size_t count = 0;
+
+    std::vector<GRNode *> nodePtrs;
+};
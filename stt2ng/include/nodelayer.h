@@ -0,0 +1,74 @@
+#pragma once
+
+#include "rendermodel.h"
+
+#include <QGraphicsItem>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Draws all nodes of a scene as a single item.
+ *
+ * Every node is an ellipse, kept in a flat array by its index in the model
+ * and drawn in the fill, outline and scale around its center given by the
+ * RenderModel. Only the projected ellipses belong to the layer. A uniform
+ * grid over the node centers limits painting to the exposed nodes and answers
+ * hit tests. When the view is zoomed out so far that a node covers only a few
+ * pixels, the nodes are drawn as one point each.
+ */
+class NodeLayer : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 16 };
+    explicit NodeLayer(const RenderModel *render, QGraphicsItem *parent = nullptr);
+
+    int type() const override { return Type; }
+    QRectF boundingRect() const override { return bounds; }
+
+    // rect is the unscaled ellipse of the node in scene coordinates
+    void addNode(int index, const QRectF &rect);
+    void removeNode(int index);
+    void clear();
+
+    bool contains(int index) const {
+        return index >= 0 && index < static_cast<int>(rects.size()) && !rects[index].isNull();
+    }
+    QPointF center(int index) const { return rects[index].center(); }
+
+    // whether the unscaled ellipses of the two nodes overlap
+    bool collides(int a, int b) const;
+
+    // index of the node containing pos closest to its center, -1 if there is none
+    int nodeAt(const QPointF &pos) const;
+
+protected:
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+private:
+    const RenderModel *render;
+
+    std::vector<QRectF> rects;
+
+    // room for every node at the largest scale
+    QRectF bounds;
+
+    // largest unscaled extent of a node, bounds the cells a query has to visit
+    double maxExtent = 0;
+
+    // grid of node indices by the cell of their center
+    double cellSize = 0;
+    std::unordered_map<std::uint64_t, std::vector<int>> cells;
+
+    std::uint64_t cellKey(int x, int y) const {
+        return (std::uint64_t(std::uint32_t(x)) << 32) | std::uint32_t(y);
+    }
+    int cellCoordinate(double value) const;
+
+    // calls f for every node whose center cell may put it inside rect
+    template <typename F>
+    void forEachNode(const QRectF &rect, F f) const;
+
+    QRectF scaledRect(int index) const;
+};
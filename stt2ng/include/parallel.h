@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Parallel {
+
+// 0 selects one thread per hardware core
+inline int resolveThreadCount(int threads)
+{
+    if (threads > 0) return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/*
+ * Calls fn(index, worker) for every index in [0, count) using up to
+ * `threads` threads, where worker is in [0, threads) and identifies the
+ * thread, e.g. for per-thread scratch buffers. Indices are handed out
+ * dynamically, so their processing order is unspecified.
+ *
+ * The calling thread takes part in the work (as worker 0) and calls
+ * poll(completed) after each index it processed and once at the end. poll
+ * is never called from any other thread, which makes it safe to report
+ * progress to e.g. the GUI from there.
+ */
+template <typename Fn, typename Poll>
+void forEach(size_t count, int threads, Fn &&fn, Poll &&poll)
+{
+    std::atomic<size_t> next {0};
+    std::atomic<size_t> done {0};
+
+    auto work = [&](int worker) {
+        for (size_t i = next++; i < count; i = next++) {
+            fn(i, worker);
+            ++done;
+
+            if (worker == 0) {
+                poll(done.load());
+            }
+        }
+    };
+
+    const int workerCount = static_cast<int>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(count, 1)));
+
+    std::vector<std::thread> workers;
+    for (int worker = 1; worker < workerCount; ++worker) {
+        workers.emplace_back(work, worker);
+    }
+
+    work(0);
+
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    poll(count);
+}
+
+template <typename Fn>
+void forEach(size_t count, int threads, Fn &&fn)
+{
+    forEach(count, threads, std::forward<Fn>(fn), [](size_t) {});
+}
+
+}
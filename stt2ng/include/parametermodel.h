@@ -1,12 +1,28 @@
 #pragma once
 
+#include <QAbstractTableModel>
 #include <QFile>
 #include <QJsonDocument>
-#include <QStandardItemModel>
+#include <GRVector>
+
+#include "csvtable.h"
 
 class GeometryParameter;
 
-class ParameterModel : public QStandardItemModel {
+// Per-row cylinder parameters, resolved into one contiguous array per field.
+struct CylinderColumns {
+    std::vector<int> ids;
+    std::vector<GeomRel::GRVector3> positions;
+    std::vector<GeomRel::GRVector3> directions;
+    std::vector<double> radii;
+    std::vector<double> lengths;
+    // rows left out because their id or geometry is not a usable number
+    int skippedRows = 0;
+
+    size_t size() const { return ids.size(); }
+};
+
+class ParameterModel : public QAbstractTableModel {
     Q_OBJECT
 public:
     struct ParseResult {
@@ -52,10 +68,21 @@ public:
         return parameters;
     }
 
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // numeric value of a cell, NaN if the cell does not hold a number
+    double value(int row, int column) const { return table.value(row, column); }
+    const CSVTable &getTable() const { return table; }
+
+    // row 0 holds the column names, so data starts at row 1 by default
+    CylinderColumns resolveCylinders(int firstRow = 1) const;
+
     ParseResult loadDescription(QFile &file);
     void saveDescription(QFile &file);
 
-    void loadCSV(QFile &file);
+    bool loadCSV(QFile &file, QString *error = nullptr);
 
     bool isPopulated() {return populated;}
 
@@ -76,6 +103,7 @@ private:
     Geometry currentGeometry = Cylindrical;
 
     QString currentCSV;
+    CSVTable table;
 
     QMap<Geometry, QVector<QString>> parameterOrder;
     QMap<Geometry, QMap<QString, GeometryParameter *>> parameters;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/*
+ * Neighbourhood relation in compressed sparse row (CSR) form.
+ *
+ * Row i belongs to the node with id ids[i]. Its neighbours are
+ * neighbours[offsets[i]] up to neighbours[offsets[i + 1] - 1], given as row
+ * indices, and orders[k] is the order (graph distance) at which
+ * neighbours[k] is reached. Each row is sorted by order, then by row index,
+ * so the neighbours up to any order form a prefix of the row.
+ */
+struct Relation
+{
+    // orders are stored in a single byte
+    static constexpr int maxSupportedOrder = 255;
+    // id of the rows of removed nodes; every other id, negative ones
+    // included, belongs to a node
+    static constexpr std::int32_t removedId = -1;
+
+    // receives the rows of a relation in order instead of storing them
+    using RowSink = std::function<void(int row, const std::int32_t *neighbours,
+                                       const std::uint8_t *orders, std::size_t count)>;
+
+    int maxOrder = 0;
+
+    std::vector<std::int32_t> ids;
+    std::vector<std::uint64_t> offsets {0};
+    std::vector<std::int32_t> neighbours;
+    std::vector<std::uint8_t> orders;
+
+    int size() const { return static_cast<int>(ids.size()); }
+    std::uint64_t edgeCount() const { return neighbours.size(); }
+
+    std::uint64_t rowBegin(int row) const { return offsets[row]; }
+    std::uint64_t rowEnd(int row) const { return offsets[row + 1]; }
+
+    // end of the neighbours of row up to the given order
+    std::uint64_t rowEnd(int row, int order) const {
+        return std::upper_bound(orders.begin() + offsets[row], orders.begin() + offsets[row + 1],
+                                order) - orders.begin();
+    }
+
+    // copy holding only the neighbours up to the given order
+    Relation upToOrder(int order) const;
+
+    /*
+     * Builds the relation up to maxOrder from the first-order pairs, given
+     * as (row, row) with the smaller row first, sorted and without
+     * duplicates. Higher orders are found by a BFS from every node that
+     * stops at maxOrder, run on `threads` threads (0 for all cores).
+     * Callers validate maxOrder against 1 and maxSupportedOrder; it is only
+     * clamped as a last resort. Setting cancelled stops the search early,
+     * leaving the relation incomplete.
+     *
+     * With a sink, every row is passed to it as soon as it is complete and
+     * the returned relation only holds the ids.
+     */
+    static Relation fromFirstOrder(const std::vector<std::int32_t> &ids,
+                                   const std::vector<std::pair<int, int>> &pairs,
+                                   int maxOrder, int threads = 1,
+                                   const std::atomic<bool> *cancelled = nullptr,
+                                   const RowSink &sink = nullptr);
+};
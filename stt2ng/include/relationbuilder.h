@@ -0,0 +1,172 @@
+#pragma once
+
+#include <GRCylinder>
+#include <GRNode>
+
+#include "relation.h"
+#include "spatialgrid.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Multi-threaded neighbourhood relation builder.
+ *
+ * Offers the same interface as GeomRel::GRBuilder. The nodes are split into
+ * spatial blocks, either slabs along one axis or the cells of a uniform grid
+ * (see SpatialGrid); for each block, the first-order relation between its own
+ * nodes and every node close enough to interact with them is computed by a
+ * GRBuilder on private copies of those nodes, so blocks can be processed
+ * concurrently. Block results are merged in a fixed order, so the output
+ * does not depend on scheduling. Higher orders are derived from the merged
+ * first-order graph by a bounded BFS over its CSR form (see Relation).
+ *
+ * Whether a block sees every node that a single GRBuilder pass would pair
+ * with its own depends on the search margin, which is an estimate: GRBuilder
+ * does not document its proximity criterion. checkPartitions compares the
+ * partitioned builds against a single pass on a given geometry.
+ *
+ * Partitioning requires every node to be a GRCylinder with finite bounds.
+ * For other nodes, or when a single thread is requested without the
+ * spatial grid, the first order is built by a single GRBuilder on the
+ * original nodes.
+ *
+ * The first-order pairs of the last build are kept until the nodes change.
+ * Building again at the same tolerance reuses them as they are, so changing
+ * only the order costs a BFS. Only a partitioned build (more than one thread
+ * or the grid) goes further: at a different tolerance, assuming that a
+ * larger tolerance never removes a neighbour, it tests again only the pairs
+ * that can change, each by a GRBuilder on copies of just those two nodes:
+ * the retained pairs when lowering it, the nearby pairs not yet retained
+ * when raising it. GRBuilder reports no distances to re-threshold, and the
+ * assumption is not checked, so the single pass builds everything again.
+ */
+class RelationBuilder
+{
+    using GRNode = GeomRel::GRNode;
+    using GRCylinder = GeomRel::GRCylinder;
+public:
+    using ProgressCallback = std::function<void(void)>;
+    using EdgeCallback = std::function<void(int, int, int)>;
+
+    RelationBuilder() = default;
+
+    // also drops the first-order pairs retained from the last build
+    void setNodes(const std::vector<GRNode *> &nodes);
+
+    // As setNodes, but keeps the retained pairs between nodes that are
+    // passed again, by id, and not listed in changedIds; pairs with nodes
+    // that are gone are dropped. Changed and new nodes are only recorded
+    // here: the next build, if partitioned, first tests them against the
+    // nodes near them, at the tolerance of the last build, on its own
+    // threads; a single pass builds everything again. Higher orders follow
+    // from its BFS.
+    void updateNodes(const std::vector<GRNode *> &nodes, const std::vector<int> &changedIds);
+
+    // 0 uses one thread per hardware core
+    void setThreadCount(int count) { threads = count; }
+    int threadCount() const { return threads; }
+
+    // limit candidate pairs to adjacent grid cells, also when single-threaded
+    void setUseSpatialGrid(bool use) { useGrid = use; }
+    bool usesSpatialGrid() const { return useGrid; }
+
+    // as GRBuilder::build, records the neighbours found on the nodes
+    void build(int order, double tolerance,
+               ProgressCallback progressCallback = [](){},
+               EdgeCallback edgeCallback = [](int, int, int){});
+
+    // rows of the relation are in the order of the nodes passed to setNodes,
+    // which are left untouched apart from the single-GRBuilder path
+    Relation buildRelation(int order, double tolerance,
+                           ProgressCallback progressCallback = [](){});
+
+    // as buildRelation, but passes the rows to sink as they are completed
+    // instead of keeping them; false if the build was cancelled
+    bool streamRelation(int order, double tolerance, const Relation::RowSink &sink,
+                        ProgressCallback progressCallback = [](){});
+
+    // pairs a partitioned first order misses or adds, compared to the serial one
+    struct PartitionCheck {
+        std::size_t serialPairs = 0;
+        std::size_t slabsMissing = 0;
+        std::size_t slabsExtra = 0;
+        std::size_t gridMissing = 0;
+        std::size_t gridExtra = 0;
+
+        bool matches() const { return slabsMissing + slabsExtra + gridMissing + gridExtra == 0; }
+    };
+
+    // Builds the first order at the tolerance with a single GRBuilder, with
+    // slabs on at least two threads and with the grid, and compares them.
+    // The single pass records its neighbours on the nodes, as build does.
+    PartitionCheck checkPartitions(double tolerance);
+
+    // how a build with these settings is partitioned, e.g. for cache keys:
+    // "serial", "grid" or "slabs <count>"
+    static std::string partitioning(int threads, bool useGrid);
+
+    // ids of the nodes by row
+    const std::vector<std::int32_t> &nodeIds() const { return ids; }
+
+    // Can be called from any thread while buildRelation runs, which then
+    // returns an empty relation as soon as possible. A single GRBuilder pass
+    // cannot be interrupted, so it is only checked for afterwards. The flag
+    // stays set until resetCancel, so a cancel that comes before the build
+    // has started is not lost; reset it before starting the build.
+    void cancel() { cancelled = true; }
+    void resetCancel() { cancelled = false; }
+    bool wasCancelled() const { return cancelled; }
+
+private:
+    struct Block {
+        std::vector<int> owned;
+        std::vector<int> candidates;
+    };
+
+    std::vector<GRNode *> nodes;
+    std::vector<std::int32_t> ids;
+    std::vector<const GRCylinder *> cylinders;
+    std::vector<SpatialGrid::Box> bounds;
+    std::unordered_map<int, int> indexOf;
+
+    double maxRadius = 0;
+
+    int threads = 1;
+    bool useGrid = false;
+
+    std::atomic<bool> cancelled {false};
+
+    // first-order pairs of the last completed build
+    std::vector<std::pair<int, int>> retainedPairs;
+    double retainedTolerance = 0;
+    bool hasRetained = false;
+    // nodes changed by updateNodes whose pairs are not retained yet
+    std::vector<int> pendingNodes;
+
+    Relation buildRows(int order, double tolerance, ProgressCallback progressCallback,
+                       const Relation::RowSink &sink);
+
+    bool canPartition() const { return !nodes.empty() && cylinders.size() == nodes.size(); }
+    // whether the settings ask for a partitioned build and it is possible
+    bool partitioned() const;
+
+    double searchMargin(double tolerance) const;
+
+    std::vector<Block> partitionSlabs(double margin, int count) const;
+    std::vector<Block> partitionGrid(double margin) const;
+    std::vector<std::pair<int, int>> buildFirstOrder(double tolerance, const std::function<void(size_t)> &progress) const;
+    std::vector<std::pair<int, int>> buildBlocks(const std::vector<Block> &blocks, double tolerance,
+                                                 const std::function<void(size_t)> &progress) const;
+
+    bool repairRetained(const std::function<void(size_t)> &progress);
+    std::vector<std::pair<int, int>> rebuildFirstOrder(double tolerance, const std::function<void(size_t)> &progress) const;
+    std::vector<char> testPairs(const std::vector<std::pair<int, int>> &pairs, double tolerance,
+                                const std::function<void(size_t)> &progress) const;
+
+    void addPair(std::vector<std::pair<int, int>> &pairs, int id, int other) const;
+};
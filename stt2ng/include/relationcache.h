@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <string>
+
+#include "relation.h"
+#include "relationfile.h"
+
+/*
+ * On-disk cache of built relations, one binary relation file per key.
+ *
+ * The key is a hash of everything the relation depends on: the bytes of the
+ * geometry description, the bytes of the CSV it refers to, the order, the
+ * tolerance and how the build is partitioned (see
+ * RelationBuilder::partitioning). Partitioned builds are only expected to
+ * match a single pass, so relations from different partitionings are kept
+ * apart. Entries are written to a temporary file first and
+ * renamed into place, so concurrent runs never see a partial entry, and an
+ * existing valid entry is never replaced: storing a key that is already
+ * there succeeds without writing.
+ */
+class RelationCache
+{
+public:
+    explicit RelationCache(const QString &directory);
+
+    // empty if the description or its CSV cannot be read
+    static QByteArray key(const QString &descriptionPath, int order, double tolerance,
+                          const std::string &partitioning, QString *error = nullptr);
+
+    QString pathFor(const QByteArray &key) const;
+
+    // maps the entry for key into file, false if there is no valid entry
+    bool find(const QByteArray &key, RelationFile *file) const;
+    bool store(const QByteArray &key, const Relation &relation, QString *error = nullptr) const;
+
+private:
+    QString directory;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include "relation.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/*
+ * Binary relation file, the CSR arrays of a Relation stored as they are in
+ * memory so that they can be mapped and used without parsing.
+ *
+ * Layout, in native byte order, every array starting at a multiple of 8:
+ *     Header
+ *     std::int32_t  ids[nodeCount]
+ *     std::uint64_t offsets[nodeCount + 1]
+ *     std::int32_t  neighbours[edgeCount]    (row indices)
+ *     std::uint8_t  orders[edgeCount]
+ *
+ * With the SortedByOrder flag, every row is sorted by order, so the
+ * neighbours up to any order form a prefix of the row.
+ */
+class RelationFile
+{
+public:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint64_t nodeCount;
+        std::uint64_t edgeCount;
+        std::uint32_t maxOrder;
+        std::uint32_t reserved;
+    };
+
+    static constexpr char magic[8] = {'S', 'T', 'T', '2', 'N', 'G', 'R', '\0'};
+    static constexpr std::uint32_t version = 1;
+
+    enum Flags : std::uint32_t {
+        SortedByOrder = 1 << 0
+    };
+
+    static std::uint64_t align(std::uint64_t size) { return (size + 7) & ~std::uint64_t(7); }
+
+    // byte offsets of the arrays in a file with the given header
+    static std::uint64_t idsOffset() { return align(sizeof(Header)); }
+    static std::uint64_t offsetsOffset(const Header &header) {
+        return idsOffset() + align(header.nodeCount * sizeof(std::int32_t));
+    }
+    static std::uint64_t neighboursOffset(const Header &header) {
+        return offsetsOffset(header) + (header.nodeCount + 1) * sizeof(std::uint64_t);
+    }
+    static std::uint64_t ordersOffset(const Header &header) {
+        return neighboursOffset(header) + align(header.edgeCount * sizeof(std::int32_t));
+    }
+    static std::uint64_t fileSize(const Header &header) {
+        return ordersOffset(header) + header.edgeCount;
+    }
+
+    RelationFile() = default;
+    ~RelationFile() { close(); }
+
+    RelationFile(const RelationFile &) = delete;
+    RelationFile &operator=(const RelationFile &) = delete;
+
+    // maps the file and checks that its header and offsets are consistent
+    bool open(const QString &path, QString *error = nullptr);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+
+    int size() const { return static_cast<int>(header.nodeCount); }
+    std::uint64_t edgeCount() const { return header.edgeCount; }
+    int maxOrder() const { return static_cast<int>(header.maxOrder); }
+    std::uint32_t flags() const { return header.flags; }
+    bool isSortedByOrder() const { return header.flags & SortedByOrder; }
+
+    const std::int32_t *ids() const { return idArray; }
+    const std::uint64_t *offsets() const { return offsetArray; }
+    const std::int32_t *neighbours() const { return neighbourArray; }
+    const std::uint8_t *orders() const { return orderArray; }
+
+    std::uint64_t rowBegin(int row) const { return offsetArray[row]; }
+    std::uint64_t rowEnd(int row) const { return offsetArray[row + 1]; }
+
+    // end of the neighbours of row up to the given order, the file has to
+    // be sorted by order
+    std::uint64_t rowEnd(int row, int order) const {
+        return std::upper_bound(orderArray + offsetArray[row], orderArray + offsetArray[row + 1],
+                                order) - orderArray;
+    }
+
+    // copies the mapped arrays
+    Relation toRelation() const;
+
+private:
+    QFile file;
+    uchar *data = nullptr;
+
+    Header header {};
+    const std::int32_t *idArray = nullptr;
+    const std::uint64_t *offsetArray = nullptr;
+    const std::int32_t *neighbourArray = nullptr;
+    const std::uint8_t *orderArray = nullptr;
+};
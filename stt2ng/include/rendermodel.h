@@ -0,0 +1,120 @@
+#pragma once
+
+#include "graphmodel.h"
+#include "trajectory.h"
+
+#include <QColor>
+#include <QObject>
+
+#include <vector>
+
+/*
+ * What the graph scenes draw, shared by all projections.
+ *
+ * Holds the fill, outline and scale of every node by its index in the
+ * GraphModel, the direct edges between them and which of those are shown.
+ * Selection, neighbour highlighting and trajectories are applied here once,
+ * the scenes only keep the projected geometry and repaint on styleChanged.
+ */
+class RenderModel : public QObject
+{
+    Q_OBJECT
+    using GRNode = GeomRel::GRNode;
+public:
+    // largest scale a node is drawn at, the scenes reserve room for it
+    static constexpr double maxScale = 2;
+
+    explicit RenderModel(GraphModel *model, QObject *parent = nullptr);
+
+    GraphModel *graphModel() const { return model; }
+
+    bool contains(int index) const {
+        return index >= 0 && index < static_cast<int>(present.size()) && present[index];
+    }
+
+    QRgb color(int index) const { return colors[index]; }
+    // a transparent outline draws no outline
+    QRgb outline(int index) const { return outlines[index]; }
+    float scale(int index) const { return scales[index]; }
+
+    // direct edges; removed edges leave an empty slot with from and to -1,
+    // so edge indices stay valid until all edges are removed
+    int edgeCount() const { return static_cast<int>(ends.size() / 2); }
+    int from(int edge) const { return ends[2 * edge]; }
+    int to(int edge) const { return ends[2 * edge + 1]; }
+
+    // edges from or to the node
+    const std::vector<int> &edgesOf(int index) const;
+
+    // index of the edge from one node to the other, -1 if there is none
+    int findEdge(int from, int to) const;
+
+    const std::vector<int> &shownEdges() const { return shown; }
+
+    // changes whenever node indices may have been reused or hits without a
+    // node may have gained one, i.e. when nodes are added or all are removed
+    int nodeVersion() const { return version; }
+
+    // resolves the hits of the trajectory to node indices unless that was
+    // done in the current version, returns whether they were resolved again
+    bool resolve(Trajectory &trajectory) const;
+
+    // draws the hits of a resolved trajectory
+    void drawTrajectory(const Trajectory &trajectory, QColor color, double scale);
+
+    // selects the node with this id, -1 clears the selection
+    void select(int id);
+
+signals:
+    void nodeAdded(int index);
+    void nodeRemoved(int index);
+    void allNodesRemoved();
+
+    // edges from first up to edgeCount() were added
+    void edgesAdded(int first);
+    void allEdgesRemoved();
+
+    // colours, scales or the shown edges changed
+    void styleChanged();
+
+private slots:
+    void addNode(GRNode *node);
+    void removeNode(GRNode *node);
+    void removeAllNodes();
+
+    void addEdge(GRNode *from, GRNode *to, int order);
+    void addEdges(const std::vector<GraphModel::Edge> &edges);
+    void removeEdge(GRNode *from, GRNode *to);
+    void removeAllEdges();
+
+    void setSelected(int id, bool selected);
+
+private:
+    GraphModel *model;
+
+    // by node index
+    std::vector<bool> present;
+    std::vector<QRgb> colors;
+    std::vector<QRgb> outlines;
+    std::vector<float> scales;
+
+    // from and to of every edge, one after the other
+    std::vector<int> ends;
+    // edges by node index
+    std::vector<std::vector<int>> incident;
+    // edges to draw, few at a time
+    std::vector<int> shown;
+
+    int currentSelection = -1;
+    int version = 0;
+
+    void appendEdge(int from, int to);
+    void setShown(int edge, bool show);
+
+    void setColor(int index, const QColor &color);
+    void setOutline(int index, const QColor &color);
+    void setScale(int index, double scale);
+
+    void showNeighbours(int index);
+    void hideNeighbours(int index);
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Uniform grid over axis-aligned boxes, used to find the nodes that can be
+ * within a given margin of each other without testing all pairs.
+ *
+ * Boxes are hashed by the cell containing their center. Cells are as large
+ * as the widest box plus the margin, so any box within the margin of another
+ * one lies in the same or an adjacent cell.
+ */
+class SpatialGrid
+{
+public:
+    struct Box {
+        double min[3];
+        double max[3];
+
+        double center(int axis) const { return (min[axis] + max[axis]) / 2; }
+
+        bool overlaps(const Box &other, double margin) const {
+            for (int axis = 0; axis < 3; ++axis) {
+                if (max[axis] + margin < other.min[axis] || other.max[axis] + margin < min[axis]) return false;
+            }
+            return true;
+        }
+    };
+
+    struct Cell {
+        int first;
+        int last;
+    };
+
+    SpatialGrid() = default;
+
+    void build(const std::vector<Box> &boxes, double margin);
+
+    const std::vector<Box> &getBoxes() const { return boxes; }
+    double getMargin() const { return margin; }
+
+    // non-empty cells in a fixed order; the members of a cell are
+    // members()[first] up to members()[last - 1]
+    const std::vector<Cell> &cells() const { return occupied; }
+    const std::vector<int> &members() const { return sorted; }
+
+    // calls fn(index) for every indexed box within the margin of box
+    template <typename Fn>
+    void forEachNear(const Box &box, Fn &&fn) const;
+
+private:
+    std::vector<Box> boxes;
+    double margin = 0;
+
+    double origin[3] = {0, 0, 0};
+    double cellSize[3] = {1, 1, 1};
+    double maxHalfWidth[3] = {0, 0, 0};
+    std::int64_t dims[3] = {1, 1, 1};
+
+    std::vector<int> sorted;
+    std::vector<Cell> occupied;
+    std::unordered_map<std::int64_t, int> cellIndex;
+
+    std::int64_t coordinate(double value, int axis) const {
+        return static_cast<std::int64_t>(std::floor((value - origin[axis]) / cellSize[axis]));
+    }
+
+    std::int64_t key(const std::int64_t coord[3]) const {
+        return coord[0] + dims[0] * (coord[1] + dims[1] * coord[2]);
+    }
+};
+
+template <typename Fn>
+void SpatialGrid::forEachNear(const Box &box, Fn &&fn) const
+{
+    std::int64_t lo[3];
+    std::int64_t hi[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        const double reach = margin + maxHalfWidth[axis];
+        lo[axis] = std::max<std::int64_t>(0, coordinate(box.min[axis] - reach, axis));
+        hi[axis] = std::min<std::int64_t>(dims[axis] - 1, coordinate(box.max[axis] + reach, axis));
+    }
+
+    std::int64_t coord[3];
+    for (coord[2] = lo[2]; coord[2] <= hi[2]; ++coord[2]) {
+        for (coord[1] = lo[1]; coord[1] <= hi[1]; ++coord[1]) {
+            for (coord[0] = lo[0]; coord[0] <= hi[0]; ++coord[0]) {
+                auto it = cellIndex.find(key(coord));
+                if (it == cellIndex.end()) continue;
+
+                const auto &cell = occupied[it->second];
+                for (int i = cell.first; i < cell.last; ++i) {
+                    const int index = sorted[i];
+                    if (boxes[index].overlaps(box, margin)) {
+                        fn(index);
+                    }
+                }
+            }
+        }
+    }
+}
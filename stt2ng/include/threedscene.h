@@ -18,7 +18,7 @@ public:
     explicit ThreeDScene(Qt3DCore::QEntity *rootEntity);
     ~ThreeDScene();
 
-    void addCylinder(const std::unique_ptr<GRCylinder> &cylinder);
+    void addCylinder(const GRCylinder &cylinder);
     void addCylinder(const GRVector3& position, const GRVector3& direction, double radius, double length);
 
     void setDistanceScale(float scale);
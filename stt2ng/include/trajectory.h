@@ -22,6 +22,18 @@ struct Trajectory
     const int id;
     QVector<int> getHits() const { return hitIDs; }
 
+    // node index of every hit, -1 for hits without a node, as resolved
+    // against the graph in the given version (see RenderModel::nodeVersion)
+    void setIndices(const QVector<int> &indices, int unknownHits, int version) {
+        hitIndices = indices;
+        unknown = unknownHits;
+        resolvedVersion = version;
+    }
+
+    const QVector<int> &getIndices() const { return hitIndices; }
+    int getUnknownHits() const { return unknown; }
+    int getResolvedVersion() const { return resolvedVersion; }
+
     void addHit(int id) {
         hitIDs.append(id);
     }
@@ -36,6 +48,9 @@ struct Trajectory
 
 private:
     QVector<int> hitIDs;
+    QVector<int> hitIndices;
+    int unknown = 0;
+    int resolvedVersion = -1;
     QColor _color;
 };
 
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "detectioneventreader.h"
+#include "idtable.h"
+#include "relation.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Checks the trajectories of detection events against a neighbourhood
+ * relation.
+ *
+ * For every pair of consecutive hits of a trajectory, the lowest order at
+ * which the relation links their nodes is counted, so the fraction of pairs
+ * covered follows for every order up to the one the relation was built
+ * with. Events are decoded and checked in parallel, each worker counting
+ * into its own Result; the merged result does not depend on the number of
+ * threads.
+ */
+class TrajectoryAnalyser
+{
+public:
+    struct Result {
+        std::uint64_t events = 0;
+        // events that could not be decoded
+        std::uint64_t failed = 0;
+        // consecutive hits with different ids; repeated hits are skipped
+        std::uint64_t pairs = 0;
+        // pairs with at least one hit that has no node in the relation
+        std::uint64_t unknown = 0;
+        // pairs by the lowest order linking them, index 0 holds the known
+        // pairs that are not linked at all
+        std::vector<std::uint64_t> byOrder;
+
+        // pairs linked at this order or below
+        std::uint64_t covered(int order) const;
+        // covered(order) as a fraction of all pairs, unknown ones included
+        double coverage(int order) const;
+
+        void merge(const Result &other);
+    };
+
+    explicit TrajectoryAnalyser(const Relation &relation);
+
+    // 0 uses one thread per hardware core
+    void setThreadCount(int count) { threads = count; }
+    int threadCount() const { return threads; }
+
+    Result analyse(const DetectionEventReader &reader) const;
+
+    // adds the pairs of one event, its hits resolved to rows of the relation
+    void analyseEvent(const DetectionEventReader::Event &event, Result *result) const;
+
+    // row of the node with this id, -1 if the relation has none
+    int rowOf(int id) const { return rows.find(id); }
+
+private:
+    const Relation &relation;
+    // row by node id, the first row wins if an id repeats
+    IdTable rows;
+
+    int threads = 1;
+
+    // lowest order linking the rows, 0 if they are not linked
+    int orderBetween(int from, int to) const;
+};
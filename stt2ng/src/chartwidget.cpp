@@ -9,7 +9,7 @@ ChartWidget::ChartWidget(QWidget *parent)
     setLayout(new QHBoxLayout);
 }
 
-void ChartWidget::createXY(const std::vector<std::unique_ptr<GRNode>> &nodes)
+void ChartWidget::createXY(const std::vector<GRNode *> &nodes)
 {
     QChart *chart = new QChart;
     chart->setTitle("X-Y Projection");
@@ -26,7 +26,7 @@ void ChartWidget::createXY(const std::vector<std::unique_ptr<GRNode>> &nodes)
     maxX = maxY = std::numeric_limits<double>::min();
     minX = minY = std::numeric_limits<double>::max();
 
-    for (auto &node : nodes) {
+    for (auto node : nodes) {
         series->append(node->posX(), node->posY());
 
         maxX = std::max(node->posX(), maxX);
@@ -70,7 +70,7 @@ void ChartWidget::createXY(const std::vector<std::unique_ptr<GRNode>> &nodes)
     layout()->addWidget(view);
 }
 
-void ChartWidget::createZX(const std::vector<std::unique_ptr<GRNode> > &nodes)
+void ChartWidget::createZX(const std::vector<GRNode *> &nodes)
 {
     QChart *chart = new QChart;
     chart->setTitle("Z-X Projection");
@@ -87,7 +87,7 @@ void ChartWidget::createZX(const std::vector<std::unique_ptr<GRNode> > &nodes)
     maxZ = maxX = std::numeric_limits<double>::min();
     minZ = minX = std::numeric_limits<double>::max();
 
-    for (auto &node : nodes) {
+    for (auto node : nodes) {
         series->append(node->posZ(), node->posX());
 
         maxZ = std::max(node->posZ(), maxZ);
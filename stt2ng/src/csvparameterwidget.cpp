@@ -1,5 +1,4 @@
 #include "csvparameterwidget.h"
-#include "csvreader.h"
 
 #include <QVBoxLayout>
 #include <QHeaderView>
@@ -158,12 +157,13 @@ void CSVParameterWidget::saveParameters(const QString &path)
 bool CSVParameterWidget::loadCSV(const QString &path)
 {
     QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::information(nullptr, "Unable to open file for reading", file.errorString());
+
+    QString error;
+    if (!model->loadCSV(file, &error)) {
+        QMessageBox::information(nullptr, "Unable to open file for reading", error);
         return false;
     }
 
-    model->loadCSV(file);
     table->resizeColumnsToContents();
 
     emit csvLoaded(true);
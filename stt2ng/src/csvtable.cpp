@@ -0,0 +1,138 @@
+#include "csvtable.h"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+const char *findOrEnd(const char *begin, const char *end, char c)
+{
+    auto found = static_cast<const char *>(std::memchr(begin, c, end - begin));
+    return found ? found : end;
+}
+
+void trim(const char *&begin, const char *&end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '"')) ++begin;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '"')) --end;
+}
+
+double parseCell(const char *begin, const char *end)
+{
+    trim(begin, end);
+    if (begin < end && *begin == '+') ++begin;
+    if (begin == end) return NaN;
+
+    double value;
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    if (ec != std::errc() || ptr != end) {
+        return NaN;
+    }
+    return value;
+}
+
+}
+
+bool CSVTable::open(const QString &path, QString *error)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    size = file.size();
+    if (size > 0) {
+        data = reinterpret_cast<const char *>(file.map(0, size));
+        if (!data) {
+            if (error) *error = file.errorString();
+            file.close();
+            size = 0;
+            return false;
+        }
+    } else {
+        // an empty file cannot be mapped, but is still a valid (empty) table
+        data = "";
+    }
+
+    parse();
+
+    return true;
+}
+
+void CSVTable::close()
+{
+    if (size > 0 && data) {
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+
+    data = nullptr;
+    size = 0;
+    rows = 0;
+    rowOffsets.clear();
+    columns.clear();
+}
+
+QString CSVTable::text(int row, int column) const
+{
+    if (row < 0 || row >= rows) return {};
+
+    const char *cell = data + rowOffsets[row];
+    const char *lineEnd = findOrEnd(cell, data + rowOffsets[row + 1], '\n');
+
+    for (int col = 0; col < column; ++col) {
+        cell = findOrEnd(cell, lineEnd, ',');
+        if (cell == lineEnd) return {};
+        ++cell;
+    }
+
+    const char *cellEnd = findOrEnd(cell, lineEnd, ',');
+    if (cellEnd > cell && cellEnd[-1] == '\r') --cellEnd;
+
+    return QString::fromUtf8(cell, static_cast<int>(cellEnd - cell));
+}
+
+void CSVTable::parse()
+{
+    const char *p = data;
+    const char *end = data + size;
+
+    while (p < end) {
+        const char *lineEnd = findOrEnd(p, end, '\n');
+        rowOffsets.push_back(p - data);
+
+        size_t col = 0;
+        const char *cell = p;
+        while (true) {
+            const char *cellEnd = findOrEnd(cell, lineEnd, ',');
+
+            if (col == columns.size()) {
+                // rows before this one did not have this column
+                columns.emplace_back(rows, NaN);
+            }
+            columns[col].push_back(parseCell(cell, cellEnd));
+            ++col;
+
+            if (cellEnd == lineEnd) break;
+            cell = cellEnd + 1;
+        }
+
+        // pad short rows so that every column has one value per row
+        for (; col < columns.size(); ++col) {
+            columns[col].push_back(NaN);
+        }
+
+        ++rows;
+        p = lineEnd + 1;
+    }
+
+    rowOffsets.push_back(size);
+}
@@ -3,78 +3,300 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QMessageBox>
 
-DetectionEventReader::DetectionEventReader(const QString &file)
-    : file(file)
-{}
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
 
-QVector<DetectionEvent> DetectionEventReader::parseEvents(bool *success)
+namespace {
+
+const char *skipSpace(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    return p;
+}
+
+// p points at the opening quote, returns the position past the closing one
+// or nullptr if the string is not terminated
+const char *skipString(const char *p, const char *end)
 {
-    if (!file.open(QFile::ReadOnly | QFile::Text)) {
-        QMessageBox::information(nullptr, "Unable to open file for reading", file.errorString());
-        *success = false;
-        return {};
+    for (++p; p < end; ++p) {
+        if (*p == '\\') {
+            ++p;
+        } else if (*p == '"') {
+            return p + 1;
+        }
     }
+    return nullptr;
+}
 
-    // used for coloring
-    const double arc_phi = 0.618033988749895;
-
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
-
-    QVector<DetectionEvent> eventList;
-    auto root = doc.object();
-    if (root.contains("Events")) {
-        QJsonArray events = root.value("Events").toArray();
-        int i = 0;
-        for (const auto &detection : events) {
-            QJsonObject detectionObject = detection.toObject();
-            int d_id;
-            if (detectionObject.contains("ID")) {
-                d_id = detectionObject.value("ID").toInt();
-            } else {
-                d_id = i;
-                i++;
+// returns the position past the value at p, nullptr if it is malformed
+const char *skipValue(const char *p, const char *end)
+{
+    if (p >= end) return nullptr;
+
+    if (*p == '"') return skipString(p, end);
+
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        while (p < end) {
+            switch (*p) {
+            case '"':
+                p = skipString(p, end);
+                if (!p) return nullptr;
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0) return p + 1;
+                break;
             }
+            ++p;
+        }
+        return nullptr;
+    }
 
-            QVector<Trajectory> trajectories;
-            int j = 0;
-            if(detectionObject.contains("Trajectories")) {
-                double h = 1.0 / (d_id + 1.0);
-
-                QJsonArray trajectoryArray = detectionObject.value("Trajectories").toArray();
-                for (const auto &trajectory : trajectoryArray) {
-                    QJsonObject trajectoryObject = trajectory.toObject();
-                    int t_id;
-                    if (trajectoryObject.contains("ID")) {
-                        t_id = trajectoryObject.value("ID").toInt();
-                    } else {
-                        t_id = j;
-                        j++;
-                    }
+    // number, true, false or null
+    const char *begin = p;
+    while (p < end && !std::strchr(",}] \t\r\n", *p)) ++p;
+    return p > begin ? p : nullptr;
+}
+
+bool isKey(const char *begin, const char *end, const char *key)
+{
+    const size_t length = std::strlen(key);
+    return static_cast<size_t>(end - begin) == length + 2 && std::memcmp(begin + 1, key, length) == 0;
+}
+
+}
+
+bool DetectionEventReader::open(const QString &path, QString *error)
+{
+    close();
+
+    if (EventFile::isEventFile(path)) {
+        return binary.open(path, error);
+    }
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    size = file.size();
+    if (size == 0) {
+        // an empty file cannot be mapped and holds no events
+        data = "";
+        return true;
+    }
+
+    data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data) {
+        if (error) *error = file.errorString();
+        close();
+        return false;
+    }
+
+    if (!index(error)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void DetectionEventReader::close()
+{
+    if (size > 0 && data) {
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+
+    data = nullptr;
+    size = 0;
+    entries.clear();
+
+    binary.close();
+}
+
+bool DetectionEventReader::index(QString *error)
+{
+    const char *p = data;
+    const char *end = data + size;
 
-                    QVector<int> hits;
-                    if (trajectoryObject.contains("Hits")) {
-                        QJsonArray hitArray = trajectoryObject.value("Hits").toArray();
-                        for (const auto &v : hitArray) {
-                            hits.append(v.toInt());
-                        }
+    auto fail = [&](const char *at) {
+        if (error) *error = QStringLiteral("Malformed event file at byte %1.").arg(at ? at - data : size);
+        return false;
+    };
+
+    // walks the members of the object at p, calls member(key begin, key end,
+    // value) for each and expects it to return the position past the value
+    auto members = [&](const char *p, auto member) -> const char * {
+        p = skipSpace(p + 1, end);
+        if (p < end && *p == '}') return p + 1;
+
+        while (p < end) {
+            if (*p != '"') return nullptr;
+            const char *keyEnd = skipString(p, end);
+            if (!keyEnd) return nullptr;
+
+            const char *value = skipSpace(keyEnd, end);
+            if (value >= end || *value != ':') return nullptr;
+            value = skipSpace(value + 1, end);
+
+            const char *next = member(p, keyEnd, value);
+            if (!next) return nullptr;
+
+            p = skipSpace(next, end);
+            if (p < end && *p == '}') return p + 1;
+            if (p >= end || *p != ',') return nullptr;
+            p = skipSpace(p + 1, end);
+        }
+        return nullptr;
+    };
+
+    p = skipSpace(p, end);
+    if (p >= end || *p != '{') return fail(p);
+
+    // events without an id are numbered in the order they appear
+    int nextId = 0;
+
+    auto root = members(p, [&](const char *key, const char *keyEnd, const char *value) -> const char * {
+        if (!isKey(key, keyEnd, "Events")) return skipValue(value, end);
+        if (*value != '[') return nullptr;
+
+        const char *q = skipSpace(value + 1, end);
+        if (q < end && *q == ']') return q + 1;
+
+        while (q < end) {
+            Entry entry {q - data, 0, -1};
+            bool hasId = false;
+
+            if (*q == '{') {
+                q = members(q, [&](const char *key, const char *keyEnd, const char *value) -> const char * {
+                    const char *next = skipValue(value, end);
+                    if (next && isKey(key, keyEnd, "ID")) {
+                        double id = 0;
+                        std::from_chars(value, next, id);
+                        entry.id = static_cast<int>(id);
+                        hasId = true;
                     }
+                    return next;
+                });
+            } else {
+                q = skipValue(q, end);
+            }
+            if (!q) return nullptr;
+
+            entry.end = q - data;
+            if (!hasId) entry.id = nextId++;
+            entries.push_back(entry);
+
+            q = skipSpace(q, end);
+            if (q < end && *q == ']') return q + 1;
+            if (q >= end || *q != ',') return nullptr;
+            q = skipSpace(q + 1, end);
+        }
+        return nullptr;
+    });
 
-                    h += arc_phi;
-                    h = std::fmod(h, 1.0);
+    if (!root) {
+        entries.clear();
+        return fail(nullptr);
+    }
 
-                    auto traj = Trajectory(t_id, hits);
-                    traj.setColor(QColor::fromHslF(h, 1.0, 0.45));
+    return true;
+}
+
+bool DetectionEventReader::readEvent(int event, Event *out) const
+{
+    if (event < 0 || event >= eventCount()) return false;
 
-                    trajectories.append(std::move(traj));
+    if (!binary.isOpen()) return readJsonEvent(event, out);
+
+    const auto firstTrajectory = binary.eventOffsets()[event];
+    const auto lastTrajectory = binary.eventOffsets()[event + 1];
+    const auto firstHit = binary.trajectoryOffsets()[firstTrajectory];
+    const auto lastHit = binary.trajectoryOffsets()[lastTrajectory];
+
+    out->id = binary.eventIds()[event];
+    out->trajectoryIds.assign(binary.trajectoryIds() + firstTrajectory, binary.trajectoryIds() + lastTrajectory);
+
+    // offsets are relative to the first hit of the event
+    out->offsets.resize(lastTrajectory - firstTrajectory + 1);
+    for (auto t = firstTrajectory; t <= lastTrajectory; ++t) {
+        out->offsets[t - firstTrajectory] = binary.trajectoryOffsets()[t] - firstHit;
+    }
+
+    out->hits.assign(binary.hits() + firstHit, binary.hits() + lastHit);
+    if (binary.hasTimes()) {
+        out->times.assign(binary.times() + firstHit, binary.times() + lastHit);
+    } else {
+        out->times.clear();
+    }
+
+    return true;
+}
+
+bool DetectionEventReader::readJsonEvent(int event, Event *out) const
+{
+    const auto &entry = entries[event];
+    const auto bytes = QByteArray::fromRawData(data + entry.begin, static_cast<int>(entry.end - entry.begin));
+    const QJsonObject detectionObject = QJsonDocument::fromJson(bytes).object();
+
+    out->id = entry.id;
+    out->trajectoryIds.clear();
+    out->offsets.assign(1, 0);
+    out->hits.clear();
+    out->times.clear();
+
+    bool hasTimes = false;
+    int j = 0;
+    if (detectionObject.contains("Trajectories")) {
+        QJsonArray trajectoryArray = detectionObject.value("Trajectories").toArray();
+        out->trajectoryIds.reserve(trajectoryArray.size());
+        for (const auto &trajectory : trajectoryArray) {
+            QJsonObject trajectoryObject = trajectory.toObject();
+            int t_id;
+            if (trajectoryObject.contains("ID")) {
+                t_id = trajectoryObject.value("ID").toInt();
+            } else {
+                t_id = j;
+                j++;
+            }
+            out->trajectoryIds.push_back(t_id);
+
+            const auto first = out->hits.size();
+            if (trajectoryObject.contains("Hits")) {
+                QJsonArray hitArray = trajectoryObject.value("Hits").toArray();
+                for (const auto &v : hitArray) {
+                    out->hits.push_back(v.toInt());
                 }
             }
 
-            eventList.append(DetectionEvent(d_id, trajectories));
+            // optional timestamps, one per hit
+            QJsonArray timeArray = trajectoryObject.value("Times").toArray();
+            if (!timeArray.isEmpty() && !hasTimes) {
+                out->times.assign(first, std::numeric_limits<double>::quiet_NaN());
+                hasTimes = true;
+            }
+            if (hasTimes) {
+                for (size_t k = first; k < out->hits.size(); ++k) {
+                    const auto time = timeArray.at(static_cast<int>(k - first));
+                    out->times.push_back(time.isDouble() ? time.toDouble() : std::numeric_limits<double>::quiet_NaN());
+                }
+            }
+
+            out->offsets.push_back(out->hits.size());
         }
     }
-    *success = true;
-    return eventList;
+
+    return true;
 }
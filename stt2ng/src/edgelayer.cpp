@@ -0,0 +1,57 @@
+#include "edgelayer.h"
+
+#include <QPainter>
+#include <QPen>
+
+EdgeLayer::EdgeLayer(const RenderModel *render, const NodeLayer *nodes, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      render(render),
+      nodes(nodes)
+{
+    setZValue(-1000);
+}
+
+void EdgeLayer::include(int first)
+{
+    QRectF added;
+    for (int edge = first; edge < render->edgeCount(); ++edge) {
+        const int from = render->from(edge);
+        const int to = render->to(edge);
+        if (!nodes->contains(from) || !nodes->contains(to)) continue;
+
+        added |= QRectF(nodes->center(from), nodes->center(to)).normalized();
+    }
+
+    added.adjust(-1, -1, 1, 1);
+    if (!bounds.contains(added)) {
+        prepareGeometryChange();
+        bounds |= added;
+    }
+}
+
+void EdgeLayer::clear()
+{
+    prepareGeometryChange();
+    bounds = QRectF();
+}
+
+void EdgeLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+{
+    const auto &shown = render->shownEdges();
+    if (shown.empty()) return;
+
+    QVector<QLineF> lines;
+    lines.reserve(static_cast<int>(shown.size()));
+    for (int edge : shown) {
+        const int from = render->from(edge);
+        const int to = render->to(edge);
+
+        // edges between overlapping nodes would be hidden by them
+        if (!nodes->contains(from) || !nodes->contains(to) || nodes->collides(from, to)) continue;
+
+        lines.append(QLineF(nodes->center(from), nodes->center(to)));
+    }
+
+    painter->setPen(QPen(Qt::black, 1, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    painter->drawLines(lines);
+}
@@ -0,0 +1,187 @@
+#include "eventfile.h"
+
+#include "detectioneventreader.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+bool EventFile::isEventFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    char start[sizeof(magic)];
+    return file.read(start, sizeof(start)) == sizeof(start) && std::memcmp(start, magic, sizeof(magic)) == 0;
+}
+
+bool EventFile::convert(const DetectionEventReader &reader, const QString &path, QString *error)
+{
+    std::vector<std::int32_t> eventIds;
+    std::vector<std::uint64_t> eventOffsets {0};
+    std::vector<std::int32_t> trajectoryIds;
+    std::vector<std::uint64_t> trajectoryOffsets {0};
+    std::vector<std::int32_t> hits;
+    std::vector<double> times;
+    bool hasTimes = false;
+
+    eventIds.reserve(reader.eventCount());
+    eventOffsets.reserve(reader.eventCount() + 1);
+
+    DetectionEventReader::Event event;
+    for (int e = 0; e < reader.eventCount(); ++e) {
+        if (!reader.readEvent(e, &event)) {
+            if (error) *error = QStringLiteral("Unable to read event %1.").arg(e);
+            return false;
+        }
+
+        const auto firstHit = hits.size();
+        eventIds.push_back(event.id);
+        trajectoryIds.insert(trajectoryIds.end(), event.trajectoryIds.begin(), event.trajectoryIds.end());
+        for (int t = 0; t < event.trajectoryCount(); ++t) {
+            trajectoryOffsets.push_back(firstHit + event.offsets[t + 1]);
+        }
+        hits.insert(hits.end(), event.hits.begin(), event.hits.end());
+        eventOffsets.push_back(trajectoryIds.size());
+
+        // times are kept for every hit once any event has them
+        if (!event.times.empty() && !hasTimes) {
+            times.assign(firstHit, std::numeric_limits<double>::quiet_NaN());
+            hasTimes = true;
+        }
+        if (hasTimes) {
+            if (event.times.empty()) {
+                times.resize(hits.size(), std::numeric_limits<double>::quiet_NaN());
+            } else {
+                times.insert(times.end(), event.times.begin(), event.times.end());
+            }
+        }
+    }
+
+    Header header {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.flags = hasTimes ? HasTimes : 0;
+    header.eventCount = eventIds.size();
+    header.trajectoryCount = trajectoryIds.size();
+    header.hitCount = hits.size();
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = QStringLiteral("Unable to open %1 for writing.").arg(path);
+        return false;
+    }
+
+    bool written = true;
+    auto write = [&](const void *data, std::uint64_t length) {
+        static const char zeros[8] = {};
+        if (length > 0) {
+            written = written && file.write(static_cast<const char *>(data), length) == static_cast<qint64>(length);
+        }
+        const auto padding = align(length) - length;
+        if (padding > 0) {
+            written = written && file.write(zeros, padding) == static_cast<qint64>(padding);
+        }
+    };
+
+    write(&header, sizeof(header));
+    write(eventIds.data(), eventIds.size() * sizeof(std::int32_t));
+    write(eventOffsets.data(), eventOffsets.size() * sizeof(std::uint64_t));
+    write(trajectoryIds.data(), trajectoryIds.size() * sizeof(std::int32_t));
+    write(trajectoryOffsets.data(), trajectoryOffsets.size() * sizeof(std::uint64_t));
+    write(hits.data(), hits.size() * sizeof(std::int32_t));
+    if (hasTimes) {
+        write(times.data(), times.size() * sizeof(double));
+    }
+
+    file.close();
+    if (!written) {
+        if (error) *error = QStringLiteral("Unable to write %1.").arg(path);
+        return false;
+    }
+
+    return true;
+}
+
+bool EventFile::open(const QString &path, QString *error)
+{
+    close();
+
+    auto fail = [&](const QString &message) {
+        if (error) *error = message;
+        close();
+        return false;
+    };
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QStringLiteral("Unable to open %1 for reading.").arg(path));
+    }
+
+    const auto size = static_cast<std::uint64_t>(file.size());
+    if (size < sizeof(Header)) {
+        return fail(QStringLiteral("%1 is not an event file.").arg(path));
+    }
+
+    data = file.map(0, file.size());
+    if (!data) {
+        return fail(QStringLiteral("Unable to map %1.").arg(path));
+    }
+
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        return fail(QStringLiteral("%1 is not an event file.").arg(path));
+    }
+    if (header.version != version) {
+        return fail(QStringLiteral("%1 has unsupported version %2.").arg(path).arg(header.version));
+    }
+
+    // counts this large cannot come from a file that fits the size check
+    const auto limit = static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max());
+    if (header.eventCount > limit || header.trajectoryCount > size || header.hitCount > size
+        || fileSize(header) != size)
+    {
+        return fail(QStringLiteral("%1 is truncated or corrupt.").arg(path));
+    }
+
+    eventIdArray = reinterpret_cast<const std::int32_t *>(data + eventIdsOffset());
+    eventOffsetArray = reinterpret_cast<const std::uint64_t *>(data + eventOffsetsOffset(header));
+    trajectoryIdArray = reinterpret_cast<const std::int32_t *>(data + trajectoryIdsOffset(header));
+    trajectoryOffsetArray = reinterpret_cast<const std::uint64_t *>(data + trajectoryOffsetsOffset(header));
+    hitArray = reinterpret_cast<const std::int32_t *>(data + hitsOffset(header));
+    timeArray = hasTimes() ? reinterpret_cast<const double *>(data + timesOffset(header)) : nullptr;
+
+    // keep every access through the offsets inside the mapping
+    auto ascending = [](const std::uint64_t *offsets, std::uint64_t count, std::uint64_t total) {
+        if (offsets[0] != 0 || offsets[count] != total) return false;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            if (offsets[i] > offsets[i + 1]) return false;
+        }
+        return true;
+    };
+    if (!ascending(eventOffsetArray, header.eventCount, header.trajectoryCount)
+        || !ascending(trajectoryOffsetArray, header.trajectoryCount, header.hitCount))
+    {
+        return fail(QStringLiteral("%1 is truncated or corrupt.").arg(path));
+    }
+
+    return true;
+}
+
+void EventFile::close()
+{
+    if (data) {
+        file.unmap(data);
+        data = nullptr;
+    }
+    file.close();
+
+    header = {};
+    eventIdArray = nullptr;
+    eventOffsetArray = nullptr;
+    trajectoryIdArray = nullptr;
+    trajectoryOffsetArray = nullptr;
+    hitArray = nullptr;
+    timeArray = nullptr;
+}
@@ -1,5 +1,8 @@
 #include "geometryparameter.h"
 
+#include <cmath>
+#include <limits>
+
 using GRVector2 = GeomRel::GRVector2;
 using GRVector3 = GeomRel::GRVector3;
 
@@ -71,12 +74,23 @@ void GeometryParameter::setIsColumnValue(bool value)
     emit columnValueChanged(columnar);
 }
 
+double GeometryParameter::cellValue(int row, double column) const
+{
+    // cells without a number, or outside the table, read as 0
+    const double value = context->value(row, column);
+    return std::isfinite(value) ? value : 0;
+}
+
 int GeometryParameter::toInt(int row)
 {
     auto val = getFieldValue();
 
     if (isColumnValue()) {
-        return context->item(row, val)->data().toInt();
+        const double value = cellValue(row, val);
+        if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) {
+            return 0;
+        }
+        return static_cast<int>(value);
     }
     return val;
 }
@@ -86,7 +100,7 @@ double GeometryParameter::toDouble(int row)
     auto val = getFieldValue();
 
     if (isColumnValue()) {
-        return context->item(row, val)->data().toDouble();
+        return cellValue(row, val);
     }
     return val;
 }
@@ -98,9 +112,9 @@ GRVector3 GeometryParameter::toGRVector3(int row)
     auto z = getFieldValue("Z");
 
     if (isColumnValue()){
-        return {context->item(row, x)->data().toDouble(),
-                context->item(row, y)->data().toDouble(),
-                context->item(row, z)->data().toDouble()};
+        return {cellValue(row, x),
+                cellValue(row, y),
+                cellValue(row, z)};
     }
 
     return {x, y, z};
@@ -112,9 +126,29 @@ GRVector2 GeometryParameter::toGRVector2(int row)
     auto y = getFieldValue("Y");
 
     if (isColumnValue()){
-        return {context->item(row, x)->data().toDouble(),
-                context->item(row, y)->data().toDouble()};
+        return {cellValue(row, x),
+                cellValue(row, y)};
     }
 
     return {x, y};
 }
+
+GeometryParameter::Span GeometryParameter::toSpan(const QString &field) const
+{
+    Span span;
+    auto val = getFieldValue(field);
+
+    if (isColumnValue()) {
+        const int column = static_cast<int>(val);
+        const auto &table = context->getTable();
+        if (column >= 0 && column < table.columnCount()) {
+            span.data = table.column(column);
+        } else {
+            span.value = std::numeric_limits<double>::quiet_NaN();
+        }
+    } else {
+        span.value = val;
+    }
+
+    return span;
+}
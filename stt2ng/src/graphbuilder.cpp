@@ -2,25 +2,161 @@
 
 #include "graphmodel.h"
 
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <GRCylinder>
+
+#include <algorithm>
+
 using namespace GeomRel;
 
+namespace {
+
+// rows of the relation added to the model per event loop iteration
+constexpr int rowsPerBatch = 1024;
+
+}
+
 GraphBuilder::GraphBuilder(GraphModel *model, QObject *parent)
     : QObject(parent),
       model(model)
-{}
+{
+    connect(&watcher, &QFutureWatcher<void>::finished, this, &GraphBuilder::relationFinished);
 
-void GraphBuilder::build(int order, double tolerance, std::function<void(void)> progressCallback)
+    connect(model, &GraphModel::nodeAdded, this, [this] { nodesChanged = true; });
+    connect(model, &GraphModel::nodeRemoved, this, [this] { nodesChanged = true; });
+    connect(model, &GraphModel::allNodesRemoved, this, [this] { nodesChanged = true; });
+}
+
+GraphBuilder::~GraphBuilder()
+{
+    waitForBuild();
+}
+
+void GraphBuilder::build(int order, double tolerance)
 {
-    auto nodes = model->getNodes();
+    if (building) return;
+
+    building = true;
+    cancelled = false;
+    ++generation;
+    relation = Relation();
+    nextRow = 0;
+
+    builder.setThreadCount(threads);
+    builder.setUseSpatialGrid(useGrid);
+
+    if (nodesChanged) {
+        builder.setNodes(model->getNodes());
+        nodesChanged = false;
+    }
+
+    // on this thread, so that a cancel before the worker starts still counts
+    builder.resetCancel();
+
+    const int maximum = getNodeCount() + order;
+    emit progressChanged(0, maximum);
+
+    watcher.setFuture(QtConcurrent::run([this, order, tolerance, maximum] {
+        // only emit when the percentage changes, so the GUI thread is not
+        // flooded with queued signals
+        int value = 0;
+        int lastPercent = 0;
+        relation = builder.buildRelation(order, tolerance, [&] {
+            ++value;
+            const int percent = maximum > 0 ? value * 100 / maximum : 100;
+            if (percent != lastPercent) {
+                lastPercent = percent;
+                emit progressChanged(value, maximum);
+            }
+        });
+    }));
+}
+
+void GraphBuilder::cancel()
+{
+    if (!building) return;
+
+    cancelled = true;
+    builder.cancel();
+}
+
+void GraphBuilder::relationFinished()
+{
+    // a build that was waited for has already been finished, and the signal
+    // of its future may only arrive once the next one has started
+    if (!building || !watcher.isFinished()) return;
+
+    if (cancelled || builder.wasCancelled()) {
+        finishBuild();
+        return;
+    }
+
+    addEdgeBatch();
+}
 
-    builder.setNodes(nodes);
-    builder.build(order, tolerance,
-        progressCallback,
-        [=](int id, int other, int ord) {
-            model->addEdge(id, other, ord);
+void GraphBuilder::addEdgeBatch()
+{
+    if (!building) return;
+
+    if (cancelled) {
+        // leave no partial relation behind
+        model->removeAllEdges();
+        finishBuild();
+        return;
+    }
+
+    const int end = std::min(nextRow + rowsPerBatch, relation.size());
+
+    std::vector<GraphModel::Edge> edges;
+    edges.reserve((relation.rowBegin(end) - relation.rowBegin(nextRow)) / 2);
+    for (int row = nextRow; row < end; ++row) {
+        for (auto k = relation.rowBegin(row); k < relation.rowEnd(row); ++k) {
+            const int other = relation.neighbours[k];
+            if (other < row) continue;
+
+            edges.push_back({relation.ids[row], relation.ids[other], relation.orders[k]});
         }
-    );
-    emit buildCompleted();
+    }
+    nextRow = end;
+
+    model->addEdges(edges);
+
+    if (nextRow < relation.size()) {
+        QTimer::singleShot(0, this, [this, queuedFor = generation] {
+            if (queuedFor == generation) addEdgeBatch();
+        });
+        return;
+    }
+
+    finishBuild();
+}
+
+void GraphBuilder::finishBuild()
+{
+    relation = Relation();
+    building = false;
+
+    if (cancelled) {
+        emit buildCancelled();
+    } else {
+        emit buildCompleted();
+    }
+}
+
+void GraphBuilder::waitForBuild()
+{
+    if (!building) return;
+
+    cancel();
+    watcher.waitForFinished();
+
+    // drops a batch that is still queued
+    ++generation;
+    relation = Relation();
+    building = false;
+    emit buildCancelled();
 }
 
 void GraphBuilder::clearAll()
@@ -31,27 +167,58 @@ void GraphBuilder::clearAll()
 
 void GraphBuilder::clearNodes()
 {
+    // the worker reads the nodes, so it has to be stopped first
+    waitForBuild();
     model->removeAllNodes();
 }
 
 void GraphBuilder::clearEdges()
 {
+    waitForBuild();
     model->removeAllEdges();
 }
 
 int GraphBuilder::getNodeCount()
 {
     if (model) {
-        return model->getNodes().size();
+        return model->getNodeCount();
     }
     return 0;
 }
 
-void GraphBuilder::addNodes(std::vector<std::unique_ptr<GRNode>> nodes)
+int GraphBuilder::addNodes(std::unique_ptr<NodeArena> nodes)
 {
     clearAll();
 
-    for (int i = 0; i < nodes.size(); ++i) {
-        model->addNode(std::move(nodes[i]));
+    return model->addNodes(std::move(nodes));
+}
+
+int GraphBuilder::updateNodes(std::unique_ptr<NodeArena> nodes)
+{
+    auto sameGeometry = [](const GRNode *node, const GRNode *other) {
+        auto a = dynamic_cast<const GRCylinder *>(node);
+        auto b = dynamic_cast<const GRCylinder *>(other);
+        if (!a || !b) return false;
+
+        return a->center.x() == b->center.x() && a->center.y() == b->center.y() && a->center.z() == b->center.z()
+            && a->direction.x() == b->direction.x() && a->direction.y() == b->direction.y()
+            && a->direction.z() == b->direction.z()
+            && a->length == b->length && a->radius == b->radius
+            && a->nodeScale() == b->nodeScale() && a->spacing() == b->spacing();
+    };
+
+    std::vector<int> changedIds;
+    for (auto node : nodes->nodes()) {
+        auto current = model->getNode(node->id());
+        if (!current || !sameGeometry(current, node)) {
+            changedIds.push_back(node->id());
+        }
     }
+
+    clearAll();
+    const int rejected = model->addNodes(std::move(nodes));
+
+    builder.updateNodes(model->getNodes(), changedIds);
+    nodesChanged = false;
+    return rejected;
 }
@@ -1,76 +1,204 @@
 #include "graphmodel.h"
 
+#include <algorithm>
+#include <tuple>
+
 using namespace GeomRel;
 
-void GraphModel::addNode(std::unique_ptr<GRNode> node)
+bool GraphModel::insertNode(GRNode *node)
 {
-    emit nodeAdded(node.get());
+    const int id = node->id();
+    if (id == Relation::removedId || !indices.insert(id, static_cast<int>(nodes.size()))) return false;
+
+    nodes.push_back(node);
+    ++nodeCount;
+    relationValid = false;
 
-    ids.insert(std::make_pair(node->id(), node->id()));
-    nodes.insert(std::make_pair(node->id(), std::move(node)));
+    emit nodeAdded(node);
+    return true;
+}
+
+bool GraphModel::addNode(std::unique_ptr<GRNode> node)
+{
+    if (!insertNode(node.get())) return false;
+
+    ownedNodes.push_back(std::move(node));
+    return true;
+}
+
+int GraphModel::addNodes(std::unique_ptr<NodeArena> arena)
+{
+    int rejected = 0;
+    nodes.reserve(nodes.size() + arena->size());
+    for (auto node : arena->nodes()) {
+        if (!insertNode(node)) ++rejected;
+    }
+
+    arenas.push_back(std::move(arena));
+    return rejected;
 }
 
 void GraphModel::addEdge(int from_id, int to_id, int order)
 {
-    auto it_from = nodes.find(from_id);
-    auto it_to = nodes.find(to_id);
-    if (it_from != nodes.end() && it_to != nodes.end()) {
-        auto from = it_from->second.get();
-        auto to = it_to->second.get();
-
-        from->addNeighbour(to->id(), order);
-        to->addNeighbour(from->id(), order);
-
-        emit edgeAdded(from, to, order);
-
-        auto it = edges.find(from->id());
-        if (it != edges.end()) {
-            auto set = it->second;
-            set.insert(to->id());
-        } else {
-            edges.insert(std::make_pair(from->id(), std::set {to->id()}));
-        }
+    const int from = indexOf(from_id);
+    const int to = indexOf(to_id);
+    if (from < 0 || to < 0) return;
+
+    nodes[from]->addNeighbour(to_id, order);
+    nodes[to]->addNeighbour(from_id, order);
+
+    edges.push_back({from, to, order});
+    relationValid = false;
+
+    emit edgeAdded(nodes[from], nodes[to], order);
+}
+
+void GraphModel::addEdges(const std::vector<Edge> &newEdges)
+{
+    std::vector<Edge> added;
+    added.reserve(newEdges.size());
+    edges.reserve(edges.size() + newEdges.size());
+
+    for (const auto &edge : newEdges) {
+        const int from = indexOf(edge.from);
+        const int to = indexOf(edge.to);
+        if (from < 0 || to < 0) continue;
+
+        nodes[from]->addNeighbour(edge.to, edge.order);
+        nodes[to]->addNeighbour(edge.from, edge.order);
+
+        edges.push_back({from, to, edge.order});
+        added.push_back(edge);
+    }
+
+    if (!added.empty()) {
+        relationValid = false;
+        emit edgesAdded(added);
     }
 }
 
 void GraphModel::removeNode(int id)
 {
-    auto it = nodes.find(id);
-    if (it != nodes.end()){
-        auto node = it->second.get();
+    const int index = indexOf(id);
+    if (index < 0) return;
+
+    auto node = nodes[index];
+
+    // drop the edges of the node first, so no edge refers to an empty slot
+    auto removed = std::stable_partition(edges.begin(), edges.end(), [index](const Edge &edge) {
+        return edge.from != index && edge.to != index;
+    });
+    for (auto it = removed; it != edges.end(); ++it) {
+        auto from = nodes[it->from];
+        auto to = nodes[it->to];
+        from->removeNeighbour(to->id());
+        to->removeNeighbour(from->id());
+        emit edgeRemoved(from, to);
+    }
+    edges.erase(removed, edges.end());
+
+    emit nodeRemoved(node);
 
-        emit nodeRemoved(node);
-        ids.erase(id);
-        nodes.erase(it);
+    indices.erase(id);
+    nodes[index] = nullptr;
+    --nodeCount;
+    relationValid = false;
+
+    auto owned = std::find_if(ownedNodes.begin(), ownedNodes.end(), [node](const std::unique_ptr<GRNode> &owned) {
+        return owned.get() == node;
+    });
+    if (owned != ownedNodes.end()) {
+        ownedNodes.erase(owned);
     }
 }
 
 void GraphModel::removeAllNodes()
 {
-    // make a local copy so the iterator is not invalidated
-    auto ids_copy = std::map(ids);
-    for (auto [pos, id] : ids_copy) {
-        removeNode(id);
-    }
-    ids.clear();
+    removeAllEdges();
+
+    emit allNodesRemoved();
+
+    indices.clear();
     nodes.clear();
+    nodeCount = 0;
+    relation = Relation();
+    relationValid = false;
+    ownedNodes.clear();
+    arenas.clear();
 }
 
 void GraphModel::removeAllEdges()
 {
-    for (auto [from_id, to_set] : edges) {
-        auto it_from = nodes.find(from_id);
-        for (int id : to_set) {
-            auto it_to = nodes.find(id);
-            if (it_from != nodes.end() && it_to != nodes.end()) {
-                auto from = it_from->second.get();
-                auto to = it_to->second.get();
-
-                from->removeNeighbour(to->id());
-                to->removeNeighbour(from->id());
-                emit edgeRemoved(from, to);
-            }
-        }
+    if (edges.empty()) return;
+
+    for (const auto &edge : edges) {
+        auto from = nodes[edge.from];
+        auto to = nodes[edge.to];
+        from->removeNeighbour(to->id());
+        to->removeNeighbour(from->id());
     }
     edges.clear();
+    relationValid = false;
+
+    emit allEdgesRemoved();
+}
+
+const Relation &GraphModel::getRelation()
+{
+    if (relationValid) return relation;
+
+    const int count = indexCount();
+
+    relation = Relation();
+    relation.ids.resize(count);
+    for (int index = 0; index < count; ++index) {
+        relation.ids[index] = nodes[index] ? nodes[index]->id() : Relation::removedId;
+    }
+
+    // counting sort of both directions of every edge by row
+    relation.offsets.assign(count + 1, 0);
+    for (const auto &edge : edges) {
+        ++relation.offsets[edge.from + 1];
+        ++relation.offsets[edge.to + 1];
+    }
+    for (int index = 0; index < count; ++index) {
+        relation.offsets[index + 1] += relation.offsets[index];
+    }
+
+    std::vector<std::pair<std::uint8_t, std::int32_t>> entries(relation.offsets[count]);
+    std::vector<std::uint64_t> fill(relation.offsets.begin(), relation.offsets.end() - 1);
+    for (const auto &edge : edges) {
+        const auto order = static_cast<std::uint8_t>(std::clamp(edge.order, 1, Relation::maxSupportedOrder));
+        entries[fill[edge.from]++] = {order, edge.to};
+        entries[fill[edge.to]++] = {order, edge.from};
+        relation.maxOrder = std::max<int>(relation.maxOrder, order);
+    }
+
+    // rows sorted by order, then index, keeping the lowest order of
+    // duplicate edges
+    std::vector<std::uint64_t> offsets {0};
+    offsets.reserve(count + 1);
+    relation.neighbours.reserve(entries.size());
+    relation.orders.reserve(entries.size());
+    for (int index = 0; index < count; ++index) {
+        auto begin = entries.begin() + relation.offsets[index];
+        auto end = entries.begin() + relation.offsets[index + 1];
+        std::sort(begin, end, [](const auto &a, const auto &b) {
+            return std::tie(a.second, a.first) < std::tie(b.second, b.first);
+        });
+        end = std::unique(begin, end, [](const auto &a, const auto &b) {
+            return a.second == b.second;
+        });
+        std::sort(begin, end);
+
+        for (auto it = begin; it != end; ++it) {
+            relation.orders.push_back(it->first);
+            relation.neighbours.push_back(it->second);
+        }
+        offsets.push_back(relation.neighbours.size());
+    }
+    relation.offsets = std::move(offsets);
+
+    relationValid = true;
+    return relation;
 }
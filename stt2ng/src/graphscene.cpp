@@ -4,84 +4,60 @@
 #include <QDebug>
 #include <cmath>
 
-GraphScene::GraphScene(GraphModel *model, GraphScene::Axes axes, QObject *parent)
+GraphScene::GraphScene(RenderModel *render, GraphScene::Axes axes, QObject *parent)
     : QGraphicsScene(parent),
-      model(model),
-      axes(axes),
-      line(nullptr)
+      line(nullptr),
+      render(render),
+      model(render->graphModel()),
+      axes(axes)
 {
-    connect(model, &GraphModel::nodeAdded, this, &GraphScene::createVisualNode);
-    connect(model, &GraphModel::nodeRemoved, this, &GraphScene::removeVisualNode);
-    connect(model, &GraphModel::edgeAdded, this, &GraphScene::createVisualEdge);
-    connect(model, &GraphModel::edgeRemoved, this, &GraphScene::removeVisualEdge);
+    // two items and the line being drawn, an index would only cost time
+    setItemIndexMethod(QGraphicsScene::NoIndex);
 
-    connect(model, &GraphModel::nodeSelected, this, [=](int id, bool selected) {
-        auto it = v_nodes.find(id);
-        if (it != v_nodes.end()) {
-            auto v_node = it->second;
-            if (selected) {
+    nodes = new NodeLayer(render);
+    addItem(nodes);
 
-                auto it = v_nodes.find(currentSelection);
-                if (it != v_nodes.end()) {
-                    it->second->setSelected(false);
-                }
+    edges = new EdgeLayer(render, nodes);
+    addItem(edges);
 
-                if (v_node->id != model->currentSelection()) {
-                    v_node->setSelected(true);
-                }
+    connect(render, &RenderModel::nodeAdded, this, &GraphScene::createVisualNode);
+    connect(render, &RenderModel::nodeRemoved, this, &GraphScene::removeVisualNode);
+    connect(render, &RenderModel::allNodesRemoved, this, &GraphScene::removeAllVisualNodes);
+    connect(render, &RenderModel::edgesAdded, this, &GraphScene::createVisualEdges);
+    connect(render, &RenderModel::allEdgesRemoved, this, &GraphScene::removeAllVisualEdges);
+    connect(render, &RenderModel::styleChanged, this, &GraphScene::updateStyle);
 
-                v_node->setBrush(Qt::green);
-                v_node->update();
-                showNeighbours(v_node);
-                currentSelection = id;
-            } else {
-                v_node->setBrush(Qt::white);
-                v_node->update();
-                hideNeighbours(v_node);
-            }
-        }
-    });
-}
-
-void GraphScene::showDetection(const DetectionEvent &event)
-{
-    auto trajectories = event.getTrajectories();
-
-    const double arc_phi = 0.618033988749895;
-
-    double new_h = 1.0 / (event.id + 1.0);
-
-    for (auto trajectory : trajectories) {
-        new_h += arc_phi;
-        new_h = std::fmod(new_h, 1.0);
-        drawTrajectory(trajectory, QColor::fromHslF(new_h, 1.0, 0.45), 1.5);
+    // nodes that are already there
+    for (int index = 0; index < model->indexCount(); ++index) {
+        if (render->contains(index)) createVisualNode(index);
     }
+    createVisualEdges(0);
 }
 
-void GraphScene::hideDetection(const DetectionEvent &event)
+QRectF GraphScene::project(const GRNode *node, Axes axes)
 {
-    auto trajectories = event.getTrajectories();
-
-    for (auto trajectory : trajectories) {
-        drawTrajectory(trajectory, Qt::white, 1.0);
+    switch (axes) {
+    case Axes::XY:
+        return QRectF(node->posX(), node->posY(), node->sizeX(), node->sizeY());
+    case Axes::XZ:
+        return QRectF(node->posZ(), node->posX(), node->sizeX(), node->sizeY());
+    case Axes::YZ:
+        return QRectF(node->posZ(), node->posY(), node->sizeX(), node->sizeY());
+    case Axes::RPhi: {
+        const double r = std::hypot(node->posX(), node->posY());
+        const double phi = std::atan2(node->posY(), node->posX());
+        return QRectF(r * phi, r, node->sizeX(), node->sizeY());
     }
-}
-
-void GraphScene::drawTrajectory(const Trajectory &trajectory, QColor color, double scale)
-{
-    for (auto hitID : trajectory.getHits()) {
-        auto it = v_nodes.find(hitID);
-        if (it == v_nodes.end()) continue;
-
-        auto node = it->second;
-        node->setBrush(color);
-        node->setScale(scale);
     }
+
+    return QRectF();
 }
 
 void GraphScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent)
 {
     if (mouseEvent->button() == Qt::LeftButton) {
+        // clicking a node selects it, clicking elsewhere clears the selection
+        render->select(nodeAt(mouseEvent->scenePos()));
 
         line = new QGraphicsLineItem(QLineF(mouseEvent->scenePos(),
                                             mouseEvent->scenePos()));
@@ -104,44 +80,20 @@ void GraphScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
 void GraphScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
 {
     if (line != nullptr) {
-        QList<QGraphicsItem *> startItems = items(line->line().p1());
-        if (startItems.count() && startItems.first() == line)
-            startItems.removeFirst();
-        QList<QGraphicsItem *> endItems = items(line->line().p2());
-        if (endItems.count() && endItems.first() == line)
-            endItems.removeFirst();
+        const int from_id = nodeAt(line->line().p1());
+        const int to_id = nodeAt(line->line().p2());
 
         QGraphicsScene::removeItem(line);
         delete line;
 
-        if (startItems.count() > 0 && endItems.count() > 0 &&
-            startItems.first()->type() == VisualGraphNode::Type &&
-            endItems.first()->type() == VisualGraphNode::Type &&
-            startItems.first() != endItems.first())
-        {
-            auto from = qgraphicsitem_cast<VisualGraphNode *>(startItems.first());
-            auto to = qgraphicsitem_cast<VisualGraphNode *>(endItems.first());
-
-            int from_id = from->id;
-            int to_id = to->id;
-
-            auto node = model->getNode(from_id);
-            if (node){
-                bool exists = false;
-                for (auto v_edge : v_edges) {
-                    if (v_edge->fromNode()->id == from_id &&
-                        v_edge->toNode()->id == to_id)
-                    {
-                        exists = true;
-                        break;
-                    }
-                }
+        if (from_id >= 0 && to_id >= 0 && from_id != to_id) {
+            const int from = model->indexOf(from_id);
+            const int to = model->indexOf(to_id);
 
-                if (!exists) {
-                    model->addEdge(from_id, to_id, 1);
-                } else {
-                    qDebug() << "Edge already exists";
-                }
+            if (render->findEdge(from, to) < 0) {
+                model->addEdge(from_id, to_id, 1);
+            } else {
+                qDebug() << "Edge already exists";
             }
         }
     }
@@ -150,169 +102,45 @@ void GraphScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
     QGraphicsScene::mouseReleaseEvent(mouseEvent);
 }
 
-void GraphScene::createVisualNode(GRNode *node)
+void GraphScene::createVisualNode(int index)
 {
-    VisualGraphNode *v_node = new VisualGraphNode(node->id(), node->sizeX(), node->sizeY());
-    connect(v_node, &VisualGraphNode::selectedChange, this, [=](bool selected) {
-        if (selected) {
-            model->selectNode(node->id());
-        } else {
-            model->deselectNode(node->id());
-        }
-    });
-
-    switch (axes) {
-    case Axes::XY:
-        v_node->setPos(node->posX(), node->posY());
-        break;
-    case Axes::XZ:
-        v_node->setPos(node->posZ(), node->posX());
-        break;
-    }
-
-    v_nodes.insert(std::make_pair(node->id(), v_node));
+    auto node = model->nodeAt(index);
+    if (!node) return;
 
-    addItem(v_node);
+    nodes->addNode(index, project(node, axes));
 }
 
-void GraphScene::removeVisualNode(GRNode *node)
+void GraphScene::removeVisualNode(int index)
 {
-    auto it = v_nodes.find(node->id());
-    if (it != v_nodes.end()) {
-        auto v_node = it->second;
-        if (currentSelection == v_node->id) {
-            hideNeighbours(v_node);
-            currentSelection = -1;
-        }
-
-        removeItem(v_node);
-        v_nodes.erase(it);
-        delete v_node;
-    }
+    nodes->removeNode(index);
 }
 
-void GraphScene::createVisualEdge(GRNode *from, GRNode *to, int order)
+void GraphScene::removeAllVisualNodes()
 {
-    auto it_from = v_nodes.find(from->id());
-    auto it_to = v_nodes.find(to->id());
-    if (it_from != v_nodes.end() && it_to != v_nodes.end()) {
-        auto from = it_from->second;
-        auto to = it_to->second;
-
-        if (order == 1) {
-            VisualGraphEdge *v_edge = new VisualGraphEdge(from, to);
-            v_edges.push_back(v_edge);
-            addItem(v_edge);
-            v_edge->updatePosition();
-        }
-    }
+    nodes->clear();
 }
 
-void GraphScene::removeVisualEdge(GRNode *from, GRNode *to)
+int GraphScene::nodeAt(const QPointF &pos) const
 {
-    for (int i = 0; i < v_edges.size(); ++i) {
-        auto edge = v_edges.at(i);
-        if (edge->fromNode()->id == from->id() &&
-            edge->toNode()->id == to->id())
-        {
-            removeItem(edge);
-
-            delete edge;
+    const int index = nodes->nodeAt(pos);
+    if (index < 0) return -1;
 
-            v_edges.erase(v_edges.begin() + i);
-            break;
-        }
-    }
+    auto node = model->nodeAt(index);
+    return node ? node->id() : -1;
 }
 
-void GraphScene::showNeighbours(VisualGraphNode *v_node)
+void GraphScene::createVisualEdges(int first)
 {
-    auto node = model->getNode(v_node->id);
-    if (!node) return;
-
-    auto direct = node->neighbours(1);
-
-    for (int id : direct) {
-        // draw direct edges
-        for (auto edge : v_edges) {
-            if (edge->fromNode()->id == v_node->id &&
-                edge->toNode()->id == id)
-            {
-                edge->setVisible(true);
-                edge->toNode()->setBrush(Qt::yellow);
-            }
-        }
-    }
-
-    const double arc_phi = 0.618033988749895;
-
-    for (int i = 2; i <= node->maxOrder(); ++i) {
-        auto neighbours = node->neighbours(i);
-
-        for (int id : neighbours) {
-            // color nodes based on order, don't draw edges
-            auto it = v_nodes.find(id);
-            if (it != v_nodes.end()) {
-                auto v_node = it->second;
-
-                double h, s, l;
-                QColor(Qt::green).getHslF(&h, &s, &l);
-
-                for (int j = 0; j < i; ++j) {
-                    h += arc_phi;
-                    h = std::fmod(h, 1.0);
-                }
-                auto color = QColor::fromHslF(h, s, l);
-                v_node->setBrush(color);
-                v_node->setPen(Qt::NoPen);
-
-                auto shadow = new QGraphicsDropShadowEffect();
-                shadow->setColor(color.darker(150));
-                shadow->setOffset(0.15, 0.15);
-                shadow->setBlurRadius(10);
-                v_node->setGraphicsEffect(shadow);
-
-                v_node->setScale(1.15);
-                v_node->update();
-            }
-        }
-    }
+    edges->include(first);
 }
 
-void GraphScene::hideNeighbours(VisualGraphNode *v_node)
+void GraphScene::removeAllVisualEdges()
 {
+    edges->clear();
+}
 
-    auto node = model->getNode(v_node->id);
-    if (!node) return;
-
-    auto direct = node->neighbours(1);
-
-    for (int id : direct) {
-        // hide direct edges
-        for (auto edge : v_edges) {
-            if (edge->fromNode()->id == v_node->id &&
-                edge->toNode()->id == id)
-            {
-                edge->setVisible(false);
-                edge->toNode()->setBrush(Qt::white);
-            }
-        }
-    }
-
-    for (int i = 2; i <= node->maxOrder(); ++i) {
-        auto neighbours = node->neighbours(i);
-
-        for (int id : neighbours) {
-            // set nodes back to default color
-            auto it = v_nodes.find(id);
-            if (it != v_nodes.end()) {
-                auto v_node = it->second;
-                v_node->setBrush(Qt::white);
-                v_node->setPen(QPen(Qt::SolidLine));
-                v_node->setGraphicsEffect(nullptr);
-                v_node->setScale(1.0);
-                v_node->update();
-            }
-        }
-    }
+void GraphScene::updateStyle()
+{
+    nodes->update();
+    edges->update();
 }
@@ -5,14 +5,19 @@
 #include <QLayout>
 #include <QKeyEvent>
 
+#include <algorithm>
+#include <cmath>
+
 GraphWidget::GraphWidget(QWidget *parent)
     : QWidget(parent),
       graphModel(new GraphModel),
+      renderModel(new RenderModel(graphModel, this)),
       graphBuilder(new GraphBuilder(graphModel, this)),
       eventModel(new QStandardItemModel(this))
 {
-    auto xy_scene = new GraphScene(graphModel, GraphScene::Axes::XY, this);
-    auto xz_scene = new GraphScene(graphModel, GraphScene::Axes::XZ, this);
+    // both projections draw the same render model
+    auto xy_scene = new GraphScene(renderModel, GraphScene::Axes::XY, this);
+    auto xz_scene = new GraphScene(renderModel, GraphScene::Axes::XZ, this);
 
     auto xy_view = new GraphView(this);
     xy_view->setScene(xy_scene);
@@ -30,34 +35,32 @@ GraphWidget::GraphWidget(QWidget *parent)
     setupEventList();
 }
 
-void GraphWidget::addDetectionEvents(const QVector<DetectionEvent> &events)
+void GraphWidget::addDetectionEvents(std::unique_ptr<DetectionEventReader> reader)
 {
+    const int set = static_cast<int>(eventSets.size());
+
     auto root = new QStandardItem(QStringLiteral("Event set %1").arg(++eventSetCount));
     root->setSelectable(true);
     root->setCheckable(false);
     root->setDragEnabled(false);
     root->setEditable(false);
     root->setData(QVariant::fromValue(QStringLiteral("EventSet")), Qt::UserRole + 1);
+    root->setData(set, Qt::UserRole + 3);
 
-    for (const auto &event : events) {
-        auto item = eventToItem(event);
-
-        root->appendRow(item);
+    QList<QStandardItem *> items;
+    items.reserve(reader->eventCount());
+    for (int event = 0; event < reader->eventCount(); ++event) {
+        items.append(eventItem(set, event, reader->eventId(event)));
     }
+    root->appendRows(items);
 
+    eventSets.push_back(std::move(reader));
     eventModel->appendRow(root);
 }
 
-void GraphWidget::addDetectionEvent(const DetectionEvent &event)
+QStandardItem *GraphWidget::eventItem(int set, int event, int id)
 {
-    auto item = eventToItem(event);
-
-    eventModel->appendRow(item);
-}
-
-QStandardItem *GraphWidget::eventToItem(const DetectionEvent &event)
-{
-    auto item = new QStandardItem(QStringLiteral("Detection ID %1").arg(event.id));
+    auto item = new QStandardItem(QStringLiteral("Detection ID %1").arg(id));
     item->setCheckable(true);
     item->setSelectable(false);
     item->setDragEnabled(false);
@@ -65,30 +68,93 @@ QStandardItem *GraphWidget::eventToItem(const DetectionEvent &event)
     item->setCheckState(Qt::CheckState::Unchecked);
     item->setData(QVariant::fromValue(QStringLiteral("DetectionEvent")), Qt::UserRole + 1);
     item->setData(true, Qt::UserRole + 2);
+    item->setData(set, Qt::UserRole + 3);
+    item->setData(event, Qt::UserRole + 4);
+
+    return item;
+}
+
+void GraphWidget::decodeEvent(QStandardItem *item)
+{
+    // trajectories are only decoded once the event is first used
+    if (item->data(Qt::UserRole + 5).toBool()) return;
+    item->setData(true, Qt::UserRole + 5);
+
+    const auto &reader = eventSets[item->data(Qt::UserRole + 3).toInt()];
+    if (!reader) return;
+
+    DetectionEventReader::Event event;
+    if (!reader->readEvent(item->data(Qt::UserRole + 4).toInt(), &event)) return;
+
+    const auto model = renderModel->graphModel();
+    event.resolve([model](int id) { return model->indexOf(id); });
+
+    // used for coloring
+    const double arc_phi = 0.618033988749895;
+    double h = 1.0 / (event.id + 1.0);
+
+    QList<QStandardItem *> trajectoryItems;
+    for (int t = 0; t < event.trajectoryCount(); ++t) {
+        QVector<int> hits(event.hits.begin() + event.offsets[t], event.hits.begin() + event.offsets[t + 1]);
+        QVector<int> indices(event.indices.begin() + event.offsets[t], event.indices.begin() + event.offsets[t + 1]);
+        const int unknown = std::count(indices.begin(), indices.end(), -1);
 
-    for (const auto &trajectory : event.getTrajectories()) {
-        auto trajectoryItem = new QStandardItem(QStringLiteral("Trajectory ID %1").arg(trajectory.id));
+        h += arc_phi;
+        h = std::fmod(h, 1.0);
+
+        Trajectory trajectory(event.trajectoryIds[t], hits);
+        trajectory.setColor(QColor::fromHslF(h, 1.0, 0.45));
+        trajectory.setIndices(indices, unknown, renderModel->nodeVersion());
+
+        auto trajectoryItem = new QStandardItem();
         trajectoryItem->setCheckable(true);
         trajectoryItem->setSelectable(false);
         trajectoryItem->setDragEnabled(false);
         trajectoryItem->setEditable(false);
         trajectoryItem->setCheckState(Qt::CheckState::Unchecked);
         trajectoryItem->setData(QVariant::fromValue(trajectory));
+        setTrajectoryText(trajectoryItem, trajectory);
 
         QPixmap pixmap(10,10);
         pixmap.fill(trajectory.getColor());
         QIcon icon(pixmap);
         trajectoryItem->setIcon(icon);
 
-        item->appendRow(trajectoryItem);
+        trajectoryItems.append(trajectoryItem);
     }
+    item->appendRows(trajectoryItems);
+}
 
-    return item;
+Trajectory GraphWidget::trajectoryOf(QStandardItem *item)
+{
+    auto trajectory = qvariant_cast<Trajectory>(item->data());
+
+    // the graph changed since the hits were resolved
+    if (renderModel->resolve(trajectory)) {
+        eventModel->blockSignals(true);
+        item->setData(QVariant::fromValue(trajectory));
+        setTrajectoryText(item, trajectory);
+        eventModel->blockSignals(false);
+    }
+
+    return trajectory;
+}
+
+void GraphWidget::setTrajectoryText(QStandardItem *item, const Trajectory &trajectory)
+{
+    // hits without a node in the graph are flagged, they are not drawn
+    if (trajectory.getUnknownHits() > 0) {
+        item->setText(QStringLiteral("Trajectory ID %1 (%2 unknown hits)")
+                      .arg(trajectory.id).arg(trajectory.getUnknownHits()));
+    } else {
+        item->setText(QStringLiteral("Trajectory ID %1").arg(trajectory.id));
+    }
 }
 
 void GraphWidget::clearEvents()
 {
     eventModel->clear();
+    eventSets.clear();
 }
 
 void GraphWidget::keyPressEvent(QKeyEvent *event)
@@ -113,6 +179,7 @@ void GraphWidget::keyPressEvent(QKeyEvent *event)
                         }
                     }
 
+                    eventSets[item->data(Qt::UserRole + 3).toInt()].reset();
                     eventModel->removeRow(item->row());
                 }
             }
@@ -132,6 +199,7 @@ void GraphWidget::setupEventList()
 
         if (state == Qt::CheckState::Checked){
             if (roleOrTrajectory.toString() == QStringLiteral("DetectionEvent")) {
+                decodeEvent(item);
                 eventView->setExpanded(item->index(), true);
                 // enable all child objects
                 for (int i = 0; i < item->rowCount(); ++i) {
@@ -152,11 +220,9 @@ void GraphWidget::setupEventList()
                         parent->setCheckState(Qt::CheckState::Checked);
                     }
                 }
-                auto trajectory = qvariant_cast<Trajectory>(roleOrTrajectory);
+                auto trajectory = trajectoryOf(item);
 
-                for (auto scene : scenes) {
-                    scene->drawTrajectory(trajectory, trajectory.getColor(), 1.25);
-                }
+                renderModel->drawTrajectory(trajectory, trajectory.getColor(), 1.25);
             }
         } else if (state == Qt::CheckState::Unchecked) {
             if (roleOrTrajectory.toString() == QStringLiteral("DetectionEvent")) {
@@ -179,11 +245,9 @@ void GraphWidget::setupEventList()
                         parent->setCheckState(Qt::CheckState::Unchecked);
                     }
                 }
-                auto trajectory = qvariant_cast<Trajectory>(roleOrTrajectory);
+                auto trajectory = trajectoryOf(item);
 
-                for (auto scene : scenes) {
-                    scene->drawTrajectory(trajectory, Qt::white, 1.0);
-                }
+                renderModel->drawTrajectory(trajectory, Qt::white, 1.0);
             }
         }
     });
@@ -201,6 +265,15 @@ void GraphWidget::setupEventList()
     eventView->setAnimated(true);
     eventView->setHeaderHidden(true);
 
+    // events without children yet are decoded when opened
+    connect(eventView, &QTreeView::doubleClicked, this, [=](const QModelIndex &index) {
+        auto item = eventModel->itemFromIndex(index);
+        if (item && item->data(Qt::UserRole + 1).toString() == QStringLiteral("DetectionEvent")) {
+            decodeEvent(item);
+            eventView->setExpanded(index, true);
+        }
+    });
+
     boxLayout->addWidget(eventView);
 
     layout()->addWidget(box);
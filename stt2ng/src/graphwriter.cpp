@@ -1,41 +1,253 @@
 #include "graphwriter.h"
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <unordered_map>
 
 using namespace GeomRel;
 
+namespace {
+
+// the buffer is written out whenever less than one number's worth is free
+constexpr std::size_t bufferSize = 1 << 20;
+constexpr std::size_t maxNumberLength = 24;
+
+}
+
 GraphWriter::GraphWriter(const std::vector<GRNode *> &nodes)
     : nodes(nodes)
 {}
 
+GraphWriter::GraphWriter(const Relation &relation)
+    : relation(&relation)
+{}
+
+GraphWriter::~GraphWriter()
+{
+    if (file) {
+        std::fclose(file);
+    }
+}
+
 bool GraphWriter::writeCSV(std::string path, std::string *error)
 {
-    if (nodes.empty()) {
+    if (nodes.empty() && (!relation || relation->size() == 0)) {
         *error =  "No nodes to output!";
         return false;
     }
 
-    std::ofstream stream;
+    Relation converted;
+    if (!relation) {
+        converted = relationOf(nodes);
+    }
+    const Relation &output = relation ? *relation : converted;
 
-    stream.open(path, std::ios::out);
-    if (!stream.is_open()) {
-        *error = "Failed to open file for writing.";
+    if (!beginCSV(path, output.ids, error)) return false;
+
+    for (int row = 0; row < output.size(); ++row) {
+        const auto begin = output.rowBegin(row);
+        writeRow(row, output.neighbours.data() + begin, output.orders.data() + begin,
+                 output.rowEnd(row) - begin);
+    }
+
+    return endCSV(error);
+}
+
+bool GraphWriter::writeBinary(std::string path, std::string *error)
+{
+    if (nodes.empty() && (!relation || relation->size() == 0)) {
+        *error =  "No nodes to output!";
         return false;
     }
 
-    // write column header
-    stream << "Id,neighbours" << std::endl;
+    Relation converted;
+    if (!relation) {
+        converted = relationOf(nodes);
+    }
+    const Relation &output = relation ? *relation : converted;
+
+    RelationFile::Header header {};
+    std::copy(std::begin(RelationFile::magic), std::end(RelationFile::magic), header.magic);
+    header.version = RelationFile::version;
+    header.nodeCount = output.size();
+    header.edgeCount = output.edgeCount();
+    header.maxOrder = output.maxOrder;
+    // relations and node lists both come grouped by ascending order
+    header.flags = RelationFile::SortedByOrder;
+
+    if (!open(path, error, false)) return false;
+
+    auto appendArray = [this](const void *data, std::size_t length) {
+        // large arrays go straight to the file
+        flush();
+        if (length > 0 && std::fwrite(data, 1, length, file) != length) {
+            failed = true;
+        }
+    };
+    auto pad = [this](std::size_t length) {
+        static const char zeros[8] = {};
+        append(zeros, RelationFile::align(length) - length);
+    };
+
+    append(reinterpret_cast<const char *>(&header), sizeof(header));
+    pad(sizeof(header));
+    appendArray(output.ids.data(), output.ids.size() * sizeof(std::int32_t));
+    pad(output.ids.size() * sizeof(std::int32_t));
+    appendArray(output.offsets.data(), output.offsets.size() * sizeof(std::uint64_t));
+    appendArray(output.neighbours.data(), output.neighbours.size() * sizeof(std::int32_t));
+    pad(output.neighbours.size() * sizeof(std::int32_t));
+    appendArray(output.orders.data(), output.orders.size());
+
+    return close(error);
+}
+
+Relation GraphWriter::relationOf(const std::vector<GRNode *> &nodes)
+{
+    Relation relation;
+
+    std::unordered_map<int, int> rowOf;
+    rowOf.reserve(nodes.size());
+    for (auto node : nodes) {
+        rowOf.emplace(node->id(), relation.size());
+        relation.ids.push_back(node->id());
+    }
+
     for (auto node : nodes) {
-        stream << node->id();
+        relation.maxOrder = std::max(relation.maxOrder, node->maxOrder());
         for (int ord = 1; ord <= node->maxOrder(); ++ord) {
             for (int id : node->neighbours(ord)) {
-                stream << "," << id;
+                auto it = rowOf.find(id);
+                if (it == rowOf.end()) continue;
+
+                relation.neighbours.push_back(it->second);
+                relation.orders.push_back(static_cast<std::uint8_t>(std::min(ord, Relation::maxSupportedOrder)));
+            }
+        }
+        relation.offsets.push_back(relation.neighbours.size());
+    }
+
+    return relation;
+}
+
+bool GraphWriter::beginCSV(const std::string &path, const std::vector<std::int32_t> &ids, std::string *error)
+{
+    rowIds = &ids;
+    return open(path, error);
+}
+
+void GraphWriter::writeRow(int row, const std::int32_t *neighbours, const std::uint8_t *orders, std::size_t count)
+{
+    const auto &ids = *rowIds;
+
+    if (ids[row] == Relation::removedId) return;
+
+    if (layout == Layout::ByOrder) {
+        for (std::size_t k = 0; k < count;) {
+            const int order = orders[k];
+            append(ids[row]);
+            append(",", 1);
+            append(order);
+            for (; k < count && orders[k] == order; ++k) {
+                reserve(maxNumberLength + 1);
+                buffer[used++] = ',';
+                append(ids[neighbours[k]]);
             }
+            append("\n", 1);
+        }
+        return;
+    }
+
+    append(ids[row]);
+    for (std::size_t k = 0; k < count; ++k) {
+        reserve(maxNumberLength + 1);
+        buffer[used++] = ',';
+        append(ids[neighbours[k]]);
+    }
+    append("\n", 1);
+}
+
+bool GraphWriter::endCSV(std::string *error)
+{
+    rowIds = nullptr;
+    return close(error);
+}
+
+bool GraphWriter::open(const std::string &path, std::string *error, bool header)
+{
+    if (file) {
+        std::fclose(file);
+    }
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        *error = "Failed to open file for writing.";
+        return false;
+    }
+
+    // the writer does its own buffering, one write per chunk
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    buffer.resize(bufferSize);
+    used = 0;
+    failed = false;
+
+    // write column header
+    if (header) {
+        if (layout == Layout::ByOrder) {
+            append("Id,Order,neighbours\n", 20);
+        } else {
+            append("Id,neighbours\n", 14);
         }
-        stream << std::endl;
     }
-    stream.close();
 
     return true;
 }
+
+bool GraphWriter::close(std::string *error)
+{
+    flush();
+
+    const bool closed = std::fclose(file) == 0;
+    file = nullptr;
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    if (failed || !closed) {
+        *error = "Failed to write to file.";
+        return false;
+    }
+
+    return true;
+}
+
+void GraphWriter::append(const char *text, std::size_t length)
+{
+    reserve(length);
+    std::copy(text, text + length, buffer.data() + used);
+    used += length;
+}
+
+void GraphWriter::append(std::int64_t value)
+{
+    reserve(maxNumberLength);
+    auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+    used = result.ptr - buffer.data();
+}
+
+void GraphWriter::reserve(std::size_t length)
+{
+    if (used + length > buffer.size()) {
+        flush();
+    }
+}
+
+void GraphWriter::flush()
+{
+    if (used == 0) return;
+
+    if (std::fwrite(buffer.data(), 1, used, file) != used) {
+        failed = true;
+    }
+    used = 0;
+}
@@ -9,18 +9,29 @@
 #ifdef ENABLE_STTS
 #include "parametermodel.h"
 #include "geometryparameter.h"
-#include "csvreader.h"
 #endif
 #include "graphwriter.h"
+#include "nodearena.h"
+#include "relationbuilder.h"
 
 #include <QCoreApplication>
 #endif
 
+#ifdef ENABLE_STTS
+#include "relationcache.h"
+#endif
+#include "detectioneventreader.h"
+#include "eventfile.h"
+#include "trajectoryanalyser.h"
+
 #include <GeomRel>
 #include <QCommandLineParser>
 #include <QDir>
 #include <STTUtil>
 
+#include <cmath>
+#include <cstdint>
+
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
@@ -28,9 +39,27 @@
 using namespace GeomRel;
 
 struct Input {
+    enum class Format {
+        CSV,
+        Binary
+    };
+
     int order = 1;
     double tolerance = 1.0;
+    int threads = 1;
+    bool spatialGrid = false;
+    bool convertEvents = false;
+    bool verifyPartitions = false;
+    Format format = Format::CSV;
+    GraphWriter::Layout layout = GraphWriter::Layout::Flat;
+    QString cacheDir;
+    QString eventFile;
     QString infile;
+
+    // sweep mode, over the tolerances and the orders from minOrder to order
+    bool sweep = false;
+    std::vector<double> tolerances;
+    int minOrder = 1;
     QString outfile;
 };
 
@@ -43,6 +72,9 @@ enum ParseResult {
     GUIError
 };
 
+// every tolerance of a sweep is built, so a range is kept to a sane size
+constexpr int maxTolerancePoints = 10000;
+
 ParseResult parseArgs(QCommandLineParser &parser, Input *input, QString *errorMsg) {
     const QCommandLineOption helpOption = parser.addHelpOption();
     const QCommandLineOption versionOption = parser.addVersionOption();
@@ -56,8 +88,48 @@ ParseResult parseArgs(QCommandLineParser &parser, Input *input, QString *errorMs
                             QCoreApplication::translate("main", "Set the desired tolerance when building the relation. Default is 1"),
                             QCoreApplication::translate("main", "tolerance")
                           },
+                          {{"j", "threads"},
+                            QCoreApplication::translate("main", "Build the relation using <threads> worker threads, in spatial blocks searched with an estimated margin that may miss pairs (see '--verify-partitions'). 0 uses all cores. Default is 1, a single exact pass"),
+                            QCoreApplication::translate("main", "threads")
+                          },
+                          {{"s", "spatial-grid"},
+                            QCoreApplication::translate("main", "Only test nodes in adjacent cells of a uniform grid when building the relation. The cells are sized with an estimated margin that may miss pairs (see '--verify-partitions'). Off by default.")
+                          },
+                          {{"l", "layout"},
+                            QCoreApplication::translate("main", "Write CSV output in <layout>, either 'flat' (all neighbours of a node in one row) or 'orders' (one row per node and order). Default is flat"),
+                            QCoreApplication::translate("main", "layout")
+                          },
+                          {{"f", "format"},
+                            QCoreApplication::translate("main", "Write the relation in <format>, either 'csv' or 'binary'. Default is csv"),
+                            QCoreApplication::translate("main", "format")
+                          },
+                          {{"e", "convert-events"},
+                            QCoreApplication::translate("main", "Convert the input, a JSON file of detection events, to the binary event format instead of building a relation.")
+                          },
+                          {{"a", "events"},
+                            QCoreApplication::translate("main", "Instead of writing the relation, print for every order up to <order> the fraction of consecutive hits of the trajectories in <events> that the relation links."),
+                            QCoreApplication::translate("main", "events")
+                          },
+                          {"verify-partitions",
+                            QCoreApplication::translate("main", "Instead of writing the relation, build its first order at the tolerance in a single pass, in slabs and in grid cells, and report the pairs the partitioned builds miss or add.")
+                          },
+                          {"tolerance-range",
+                            QCoreApplication::translate("main", "Sweep the tolerance from <start> to <stop> in steps of <step>, reusing the geometry for every value. Prints statistics, or the coverage with '-a', per order and tolerance."),
+                            QCoreApplication::translate("main", "start:stop:step")
+                          },
+                          {"order-range",
+                            QCoreApplication::translate("main", "Sweep the order from <first> to <last>, reusing the relation of the last order for the lower ones."),
+                            QCoreApplication::translate("main", "first:last")
+                          },
                       });
 
+    if constexpr (Config::enable_stts){
+        parser.addOption({{"c", "cache"},
+                          QCoreApplication::translate("main", "Reuse relations built before with the same description, CSV, order and tolerance, stored in <directory>."),
+                          QCoreApplication::translate("main", "directory")
+                         });
+    }
+
     if constexpr (Config::enable_gui){
         parser.addOption({{"g", "gui"},
                           QCoreApplication::translate("main", "Open the gui if incorrect arguments are passed.")
@@ -70,8 +142,8 @@ ParseResult parseArgs(QCommandLineParser &parser, Input *input, QString *errorMs
         parser.addPositionalArgument("pandaCSV", "The PANDA CSV data to convert. Required.");
     }
 
-    parser.addPositionalArgument("output", "File to write the neighbourhood relation to. Output will be in CSV format. "\
-                                           "If not supplied, the output will be of the form '<description>.csv'");
+    parser.addPositionalArgument("output", "File to write the neighbourhood relation to, in the format given by '-f'. "\
+                                           "If not supplied, the output will be of the form '<description>.csv' or '<description>.bin'");
 
     bool parsed = parser.parse(QCoreApplication::arguments());
     if(!parsed) {
@@ -94,8 +166,8 @@ ParseResult parseArgs(QCommandLineParser &parser, Input *input, QString *errorMs
     if (parser.isSet("o")) {
         bool ok = false;
         const int order = parser.value("o").toInt(&ok);
-        if (!ok) {
-            *errorMsg = "Argument to '-o' expects an integer.";
+        if (!ok || order < 1 || order > Relation::maxSupportedOrder) {
+            *errorMsg = QString("Argument to '-o' expects an integer from 1 to %1.").arg(Relation::maxSupportedOrder);
 
             if constexpr (!Config::enable_gui) {
                 return Error;
@@ -131,6 +203,178 @@ ParseResult parseArgs(QCommandLineParser &parser, Input *input, QString *errorMs
         cliMode = true;
     }
 
+    if (parser.isSet("j")) {
+        bool ok = false;
+        const int threads = parser.value("j").toInt(&ok);
+        if (!ok || threads < 0) {
+            *errorMsg = "Argument to '-j' expects a non-negative integer.";
+
+            if constexpr (!Config::enable_gui) {
+                return Error;
+            } else {
+                if (!parser.isSet("g")) {
+                    return Error;
+                } else {
+                    return GUIError;
+                }
+            }
+        }
+        input->threads = threads;
+        cliMode = true;
+    }
+
+    if (parser.isSet("s")) {
+        input->spatialGrid = true;
+        cliMode = true;
+    }
+
+    if (parser.isSet("l")) {
+        const QString layout = parser.value("l").toLower();
+        if (layout == "flat") {
+            input->layout = GraphWriter::Layout::Flat;
+        } else if (layout == "orders") {
+            input->layout = GraphWriter::Layout::ByOrder;
+        } else {
+            *errorMsg = "Argument to '-l' expects 'flat' or 'orders'.";
+
+            if constexpr (!Config::enable_gui) {
+                return Error;
+            } else {
+                if (!parser.isSet("g")) {
+                    return Error;
+                } else {
+                    return GUIError;
+                }
+            }
+        }
+        cliMode = true;
+    }
+
+    if (parser.isSet("f")) {
+        const QString format = parser.value("f").toLower();
+        if (format == "csv") {
+            input->format = Input::Format::CSV;
+        } else if (format == "binary") {
+            input->format = Input::Format::Binary;
+        } else {
+            *errorMsg = "Argument to '-f' expects 'csv' or 'binary'.";
+
+            if constexpr (!Config::enable_gui) {
+                return Error;
+            } else {
+                if (!parser.isSet("g")) {
+                    return Error;
+                } else {
+                    return GUIError;
+                }
+            }
+        }
+        cliMode = true;
+    }
+
+    if (parser.isSet("e")) {
+        input->convertEvents = true;
+        cliMode = true;
+    }
+
+    if (parser.isSet("a")) {
+        input->eventFile = parser.value("a");
+        cliMode = true;
+    }
+
+    if (parser.isSet("verify-partitions")) {
+        input->verifyPartitions = true;
+        cliMode = true;
+    }
+
+    if (parser.isSet("tolerance-range")) {
+        const auto parts = parser.value("tolerance-range").split(':');
+        bool ok = parts.size() == 3;
+        double start = 0, stop = 0, step = 0;
+        if (ok) {
+            bool startOk = false, stopOk = false, stepOk = false;
+            start = parts[0].toDouble(&startOk);
+            stop = parts[1].toDouble(&stopOk);
+            step = parts[2].toDouble(&stepOk);
+            ok = startOk && stopOk && stepOk && std::isfinite(start) && std::isfinite(stop) && std::isfinite(step)
+                && step > 0 && start <= stop;
+        }
+        if (!ok) {
+            *errorMsg = "Argument to '--tolerance-range' expects <start>:<stop>:<step> with start <= stop and a positive step.";
+        }
+        // stop is included despite rounding of the steps
+        const double points = ok ? std::floor((stop - start) / step + 1e-9) + 1 : 0;
+        if (ok && !(points <= maxTolerancePoints)) {
+            ok = false;
+            *errorMsg = QString("Argument to '--tolerance-range' gives more than %1 tolerances.").arg(maxTolerancePoints);
+        }
+        if (!ok) {
+            if constexpr (!Config::enable_gui) {
+                return Error;
+            } else {
+                if (!parser.isSet("g")) {
+                    return Error;
+                } else {
+                    return GUIError;
+                }
+            }
+        }
+
+        const auto count = static_cast<std::int64_t>(points);
+        input->tolerances.reserve(count);
+        for (std::int64_t i = 0; i < count; ++i) {
+            input->tolerances.push_back(start + i * step);
+        }
+        input->sweep = true;
+        cliMode = true;
+    }
+
+    if (parser.isSet("order-range")) {
+        const auto parts = parser.value("order-range").split(':');
+        bool ok = parts.size() == 2;
+        int first = 0, last = 0;
+        if (ok) {
+            bool firstOk = false, lastOk = false;
+            first = parts[0].toInt(&firstOk);
+            last = parts[1].toInt(&lastOk);
+            ok = firstOk && lastOk && first >= 1 && first <= last && last <= Relation::maxSupportedOrder;
+        }
+        if (!ok) {
+            *errorMsg = QString("Argument to '--order-range' expects <first>:<last> with 1 <= first <= last <= %1.")
+                            .arg(Relation::maxSupportedOrder);
+
+            if constexpr (!Config::enable_gui) {
+                return Error;
+            } else {
+                if (!parser.isSet("g")) {
+                    return Error;
+                } else {
+                    return GUIError;
+                }
+            }
+        }
+
+        input->minOrder = first;
+        input->order = last;
+        input->sweep = true;
+        cliMode = true;
+    }
+
+    // a sweep over the orders alone keeps the single tolerance
+    if (input->sweep && input->tolerances.empty()) {
+        input->tolerances.push_back(input->tolerance);
+    }
+    if (input->sweep && !parser.isSet("order-range")) {
+        input->minOrder = input->order;
+    }
+
+    if constexpr (Config::enable_stts) {
+        if (parser.isSet("c")) {
+            input->cacheDir = parser.value("c");
+            cliMode = true;
+        }
+    }
+
     const auto positionals = parser.positionalArguments();
     if (positionals.isEmpty()) {
         if constexpr (Config::enable_stts){
@@ -189,14 +433,222 @@ ParseResult parseArgs(QCommandLineParser &parser, Input *input, QString *errorMs
     }
 }
 
+QString outputSuffix(const Input &input) {
+    return input.format == Input::Format::Binary ? ".bin" : ".csv";
+}
+
+#ifdef ENABLE_STTS
+int writeCached(const Input &input, const RelationFile &cached, const QString &cachedPath, const QString &outpath) {
+    if (input.format == Input::Format::Binary) {
+        QFile::remove(outpath);
+        if (!QFile::copy(cachedPath, outpath)) {
+            std::cerr << "Failed to open file for writing." << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    // rows are written straight from the mapped file
+    const std::vector<std::int32_t> ids(cached.ids(), cached.ids() + cached.size());
+
+    std::string error;
+    GraphWriter writer;
+    writer.setLayout(input.layout);
+    if (!writer.beginCSV(outpath.toStdString(), ids, &error)) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+
+    for (int row = 0; row < cached.size(); ++row) {
+        const auto begin = cached.rowBegin(row);
+        writer.writeRow(row, cached.neighbours() + begin, cached.orders() + begin, cached.rowEnd(row) - begin);
+    }
+
+    if (!writer.endCSV(&error)) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+int convertEvents(const Input &input) {
+    QDir cwd;
+    QString inpath = cwd.relativeFilePath(input.infile);
+
+    QString outfile;
+    if (input.outfile.isEmpty()) {
+        QFileInfo info(inpath);
+        outfile = info.dir().path() + "/" + info.baseName() + ".bin";
+    } else {
+        outfile = input.outfile;
+    }
+
+    DetectionEventReader reader;
+    QString error;
+    if (!reader.open(inpath, &error) || !EventFile::convert(reader, cwd.relativeFilePath(outfile), &error)) {
+        std::cerr << error.toStdString() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// pairs with hits outside the geometry count as not covered
+void printCoverage(int order, double tolerance, const TrajectoryAnalyser::Result &result) {
+    printf("%d,%g,%llu,%llu,%llu,%.6f\n", order, tolerance,
+           static_cast<unsigned long long>(result.pairs),
+           static_cast<unsigned long long>(result.unknown),
+           static_cast<unsigned long long>(result.covered(order)),
+           result.coverage(order));
+}
+
+int verifyPartitions(const Input &input, RelationBuilder &builder) {
+    const auto check = builder.checkPartitions(input.tolerance);
+
+    printf("Partitioning,Tolerance,Pairs,Missing,Extra\n");
+    printf("serial,%g,%zu,0,0\n", input.tolerance, check.serialPairs);
+    printf("slabs,%g,%zu,%zu,%zu\n", input.tolerance,
+           check.serialPairs - check.slabsMissing + check.slabsExtra, check.slabsMissing, check.slabsExtra);
+    printf("grid,%g,%zu,%zu,%zu\n", input.tolerance,
+           check.serialPairs - check.gridMissing + check.gridExtra, check.gridMissing, check.gridExtra);
+
+    return check.matches() ? 0 : 1;
+}
+
+int reportCoverage(const Input &input, const DetectionEventReader &events, const Relation &relation) {
+    TrajectoryAnalyser analyser(relation);
+    analyser.setThreadCount(input.threads);
+    const auto result = analyser.analyse(events);
+
+    if (result.failed > 0) {
+        std::cerr << result.failed << " of " << result.events << " events could not be decoded." << std::endl;
+    }
+
+    printf("Order,Tolerance,Pairs,Unknown,Covered,Coverage\n");
+    for (int order = 1; order <= relation.maxOrder; ++order) {
+        printCoverage(order, input.tolerance, result);
+    }
+
+    return 0;
+}
+
+void printStatistics(int order, double tolerance, const Relation &relation) {
+    // every link is stored in the rows of both its nodes
+    std::uint64_t entries = 0;
+    std::uint64_t maxDegree = 0;
+    int isolated = 0;
+    for (int row = 0; row < relation.size(); ++row) {
+        const auto degree = relation.rowEnd(row, order) - relation.rowBegin(row);
+        entries += degree;
+        maxDegree = std::max(maxDegree, degree);
+        if (degree == 0) ++isolated;
+    }
+
+    printf("%d,%g,%d,%llu,%.3f,%llu,%d\n", order, tolerance, relation.size(),
+           static_cast<unsigned long long>(entries / 2),
+           relation.size() > 0 ? static_cast<double>(entries) / relation.size() : 0.0,
+           static_cast<unsigned long long>(maxDegree), isolated);
+}
+
+/*
+ * Builds one relation per tolerance, from the largest to the smallest, so
+ * that after the first build the builder only tests again the pairs it
+ * kept from the last one. Each is built once at the highest order, the
+ * lower orders are prefixes of its rows. With an output file, the relation
+ * of every point is written next to it, named after the order and tolerance.
+ */
+int runSweep(const Input &input, RelationBuilder &builder, const DetectionEventReader *events, const QString &outpath) {
+    auto tolerances = input.tolerances;
+    std::sort(tolerances.begin(), tolerances.end(), std::greater<double>());
+
+    if (events) {
+        printf("Order,Tolerance,Pairs,Unknown,Covered,Coverage\n");
+    } else {
+        printf("Order,Tolerance,Nodes,Edges,MeanDegree,MaxDegree,Isolated\n");
+    }
+
+    for (double tolerance : tolerances) {
+        const auto relation = builder.buildRelation(input.order, tolerance);
+
+        if (events) {
+            TrajectoryAnalyser analyser(relation);
+            analyser.setThreadCount(input.threads);
+            const auto result = analyser.analyse(*events);
+            if (result.failed > 0) {
+                std::cerr << result.failed << " of " << result.events << " events could not be decoded." << std::endl;
+            }
+
+            for (int order = input.minOrder; order <= input.order; ++order) {
+                printCoverage(order, tolerance, result);
+            }
+        } else {
+            for (int order = input.minOrder; order <= input.order; ++order) {
+                printStatistics(order, tolerance, relation);
+            }
+        }
+        fflush(stdout);
+
+        if (outpath.isEmpty()) continue;
+
+        QFileInfo info(outpath);
+        for (int order = input.minOrder; order <= input.order; ++order) {
+            const auto pointPath = QStringLiteral("%1/%2_o%3_t%4%5").arg(info.dir().path(), info.completeBaseName())
+                                   .arg(order).arg(tolerance).arg(outputSuffix(input));
+
+            Relation truncated;
+            if (order < input.order) {
+                truncated = relation.upToOrder(order);
+            }
+            GraphWriter writer(order < input.order ? truncated : relation);
+            writer.setLayout(input.layout);
+
+            std::string error;
+            const bool written = input.format == Input::Format::Binary ? writer.writeBinary(pointPath.toStdString(), &error)
+                                                                       : writer.writeCSV(pointPath.toStdString(), &error);
+            if (!written) {
+                std::cerr << error << std::endl;
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
 int acceptInput(const Input &input) {
+    if (input.convertEvents) {
+        return convertEvents(input);
+    }
 
     QDir cwd;
     QString inpath = cwd.relativeFilePath(input.infile);
 
+    // opened first, so that a bad event file fails before the build
+    DetectionEventReader events;
+    const bool analyse = !input.eventFile.isEmpty();
+    if (analyse) {
+        QString eventError;
+        if (!events.open(cwd.relativeFilePath(input.eventFile), &eventError)) {
+            std::cerr << eventError.toStdString() << std::endl;
+            return -1;
+        }
+    }
+
 #ifndef ENABLE_STTS
+    // STTUtil builds a single relation itself, so only sweeps and
+    // --verify-partitions go through RelationBuilder
+    if (input.spatialGrid && !input.sweep) {
+        std::cerr << "'-s' only applies to sweeps without STT support." << std::endl;
+        return -1;
+    }
+
     std::string error;
-    auto [ok, nodes] = STTUtil::PANDA::csvToRelation(inpath.toStdString(), &error, input.order, input.tolerance);
+    // STTUtil has no loader that stops short of a relation, so a sweep
+    // gets its nodes from a first-order build, the cheapest one
+    auto [ok, nodes] = STTUtil::PANDA::csvToRelation(inpath.toStdString(), &error,
+                                                     input.sweep || input.verifyPartitions ? 1 : input.order,
+                                                     input.tolerance);
 
     if (!ok) {
         std::cerr << error << std::endl;
@@ -208,23 +660,75 @@ int acceptInput(const Input &input) {
         node_ptrs.push_back(node.get());
     }
 
+    if (input.verifyPartitions) {
+        RelationBuilder builder;
+        builder.setThreadCount(input.threads);
+        builder.setNodes(node_ptrs);
+        return verifyPartitions(input, builder);
+    }
+
+    if (input.sweep) {
+        RelationBuilder builder;
+        builder.setThreadCount(input.threads);
+        builder.setUseSpatialGrid(input.spatialGrid);
+        builder.setNodes(node_ptrs);
+
+        const QString outpath = input.outfile.isEmpty() ? QString() : cwd.relativeFilePath(input.outfile);
+        return runSweep(input, builder, analyse ? &events : nullptr, outpath);
+    }
+
+    if (analyse) {
+        return reportCoverage(input, events, GraphWriter::relationOf(node_ptrs));
+    }
+
     GraphWriter writer(node_ptrs);
+    writer.setLayout(input.layout);
+    const bool binary = input.format == Input::Format::Binary;
 
     QString outfile;
     if (input.outfile.isEmpty()) {
         QFileInfo info(inpath);
-        outfile = info.dir().path() + "/" + info.baseName() + ".csv";
+        outfile = info.dir().path() + "/" + info.baseName() + outputSuffix(input);
     } else {
         outfile = input.outfile;
     }
 
     QString outpath = cwd.relativeFilePath(outfile);
 
-    if(!writer.writeCSV(outpath.toStdString(), &error)) {
+    const bool written = binary ? writer.writeBinary(outpath.toStdString(), &error)
+                                : writer.writeCSV(outpath.toStdString(), &error);
+    if(!written) {
         std::cerr << error << std::endl;
         return -1;
     }
 #else
+    QString outfile;
+    if (input.outfile.isEmpty()) {
+        QFileInfo info(inpath);
+        outfile = info.dir().path() + "/" + info.baseName() + outputSuffix(input);
+    } else {
+        outfile = input.outfile;
+    }
+
+    QString outpath = cwd.relativeFilePath(outfile);
+
+    RelationCache cache(input.cacheDir);
+    QByteArray cacheKey;
+    if (!input.cacheDir.isEmpty() && !analyse && !input.sweep && !input.verifyPartitions) {
+        QString cacheError;
+        cacheKey = RelationCache::key(inpath, input.order, input.tolerance,
+                                      RelationBuilder::partitioning(input.threads, input.spatialGrid), &cacheError);
+        if (cacheKey.isEmpty()) {
+            std::cerr << cacheError.toStdString() << std::endl;
+            return -1;
+        }
+
+        RelationFile cached;
+        if (cache.find(cacheKey, &cached)) {
+            return writeCached(input, cached, cache.pathFor(cacheKey), outpath);
+        }
+    }
+
     QFile infile(inpath);
     if (!infile.open(QIODevice::ReadOnly | QIODevice::Text)) {
         std::cerr << "Unable to open file for reading." << std::endl;
@@ -240,45 +744,85 @@ int acceptInput(const Input &input) {
 
     auto type = paramModel.getCurrentGeometry();
 
-    GRBuilder builder;
+    RelationBuilder builder;
+    builder.setThreadCount(input.threads);
+    builder.setUseSpatialGrid(input.spatialGrid);
 
-    std::vector<std::unique_ptr<GRNode>> nodes;
+    std::unique_ptr<NodeArena> nodes;
 
     if (type ==  ParameterModel::Geometry::Cylindrical) {
-        for (int i = 1; i < paramModel.rowCount(); ++i) {
-
-            int id = parameters.value("ID")->toInt(i);
-            GRVector3 center = parameters.value("Position")->toGRVector3(i);
-            GRVector3 direction = parameters.value("Direction")->toGRVector3(i);
-            double length = parameters.value("Length")->toDouble(i);
-            double radius = parameters.value("Radius")->toDouble(i);
+        const auto columns = paramModel.resolveCylinders();
+        if (columns.skippedRows > 0) {
+            std::cerr << "Skipped " << columns.skippedRows << " rows without a usable id or geometry." << std::endl;
+        }
+        nodes = std::make_unique<NodeArena>(columns.size());
 
-            nodes.push_back(std::make_unique<GRCylinder>(id, center, direction, 2 * length, radius));
+        for (size_t i = 0; i < columns.size(); ++i) {
+            nodes->addCylinder(columns.ids[i], columns.positions[i], columns.directions[i],
+                               2 * columns.lengths[i], columns.radii[i]);
         }
+    } else {
+        nodes = std::make_unique<NodeArena>(0);
     }
 
-    std::vector<GRNode *> node_ptrs;
-    for (auto &node : nodes) {
-        node_ptrs.push_back(node.get());
+    builder.setNodes(nodes->nodes());
+
+    std::string error;
+    if (nodes->empty()) {
+        std::cerr << "No nodes to output!" << std::endl;
+        return -1;
     }
 
-    builder.setNodes(node_ptrs);
-    builder.build(input.order, input.tolerance);
+    if (input.verifyPartitions) {
+        return verifyPartitions(input, builder);
+    }
 
-    GraphWriter writer(node_ptrs);
+    if (input.sweep) {
+        return runSweep(input, builder, analyse ? &events : nullptr, input.outfile.isEmpty() ? QString() : outpath);
+    }
 
-    QString outfile;
-    if (input.outfile.isEmpty()) {
-        QFileInfo info(inpath);
-        outfile = info.dir().path() + "/" + info.baseName() + ".csv";
-    } else {
-        outfile = input.outfile;
+    if (analyse) {
+        return reportCoverage(input, events, builder.buildRelation(input.order, input.tolerance));
     }
 
-    QString outpath = cwd.relativeFilePath(outfile);
+    // the binary layout and the cache need the whole relation
+    if (input.format == Input::Format::Binary || !cacheKey.isEmpty()) {
+        const auto relation = builder.buildRelation(input.order, input.tolerance);
 
-    std::string error;
-    if(!writer.writeCSV(outpath.toStdString(), &error)) {
+        if (!cacheKey.isEmpty()) {
+            // a failed store only costs the next run a rebuild
+            QString cacheError;
+            if (!cache.store(cacheKey, relation, &cacheError)) {
+                std::cerr << cacheError.toStdString() << std::endl;
+            }
+        }
+
+        GraphWriter writer(relation);
+        writer.setLayout(input.layout);
+        const bool written = input.format == Input::Format::Binary ? writer.writeBinary(outpath.toStdString(), &error)
+                                                                   : writer.writeCSV(outpath.toStdString(), &error);
+        if (!written) {
+            std::cerr << error << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    // rows are written while the relation is built, so it is never held
+    // in memory as a whole
+    GraphWriter writer;
+    writer.setLayout(input.layout);
+    if (!writer.beginCSV(outpath.toStdString(), builder.nodeIds(), &error)) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+
+    builder.streamRelation(input.order, input.tolerance, [&](int row, const std::int32_t *neighbours,
+                                                             const std::uint8_t *orders, std::size_t count) {
+        writer.writeRow(row, neighbours, orders, count);
+    });
+
+    if (!writer.endCSV(&error)) {
         std::cerr << error << std::endl;
         return -1;
     }
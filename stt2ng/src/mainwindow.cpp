@@ -33,6 +33,10 @@ MainWindow::MainWindow(QWidget *parent)
     progressBar->setMaximumSize(80, 10);
     ui->statusbar->addPermanentWidget(progressBar);
 
+    cancelButton = new QPushButton("Cancel", this);
+    cancelButton->setVisible(false);
+    ui->statusbar->addPermanentWidget(cancelButton);
+
     setupTableWidget();
     setupGraphWidget();
     setupChartWidget();
@@ -51,16 +55,12 @@ void MainWindow::on_buildButton_pressed()
     graphWidget->hide();
     ui->statusbar->showMessage("Building relation...");
     ui->buildButton->setEnabled(false);
-    repaint();
+    ui->generateNodesButton->setEnabled(false);
+    cancelButton->setVisible(true);
     auto builder = graphWidget->getBuilder();
 
     builder->clearEdges();
-
-    int value = 0;
-    if (progressBar) progressBar->setMaximum(builder->getNodeCount() + order);
-    builder->build(order, tolerance, [& value, this] {
-        if (progressBar) progressBar->setValue(++value);
-    });
+    builder->build(order, tolerance);
 }
 
 void MainWindow::on_clearButton_pressed()
@@ -95,12 +95,26 @@ void MainWindow::setupGraphWidget()
 {
     graphWidget = new GraphWidget(this);
     auto builder = graphWidget->getBuilder();
+    connect(builder, &GraphBuilder::progressChanged, this, [this](int value, int maximum) {
+        progressBar->setMaximum(maximum);
+        progressBar->setValue(value);
+    });
     connect(builder, &GraphBuilder::buildCompleted, this, [this] {
         graphWidget->show();
         ui->statusbar->showMessage("Done", 2000);
         progressBar->reset();
-        repaint();
+        cancelButton->setVisible(false);
+        ui->generateNodesButton->setEnabled(true);
+    });
+    connect(builder, &GraphBuilder::buildCancelled, this, [this] {
+        graphWidget->show();
+        ui->statusbar->showMessage("Build cancelled", 2000);
+        progressBar->reset();
+        cancelButton->setVisible(false);
+        ui->generateNodesButton->setEnabled(true);
+        ui->buildButton->setEnabled(true);
     });
+    connect(cancelButton, &QPushButton::clicked, builder, &GraphBuilder::cancel);
 
     ui->graphTabLayout->addWidget(graphWidget, Qt::AlignCenter);
 }
@@ -127,38 +141,38 @@ void MainWindow::setup3DView()
 }
 #endif
 
-std::vector<std::unique_ptr<GRNode>> MainWindow::generateNodes()
+std::unique_ptr<NodeArena> MainWindow::generateNodes()
 {
     auto parameters = csvWidget->getActiveParameters();
 
-    if (parameters.empty()) return {};
+    if (parameters.empty()) return std::make_unique<NodeArena>(0);
 
     auto type = csvWidget->getActiveGeometry();
     auto model = csvWidget->getModel();
 
-    std::vector<std::unique_ptr<GRNode>> nodes;
+    std::unique_ptr<NodeArena> nodes;
 
     switch (type){
     case ParameterModel::Geometry::Cylindrical: {
-        for (int i = 1; i < model->rowCount(); ++i) {
-
-            int id = parameters.value("ID")->toInt(i);
-            GRVector3 center = parameters.value("Position")->toGRVector3(i);
-            GRVector3 direction = parameters.value("Direction")->toGRVector3(i);
-            double length = parameters.value("Length")->toDouble(i);
-            double radius = parameters.value("Radius")->toDouble(i);
+        const auto columns = model->resolveCylinders();
+        if (columns.skippedRows > 0) {
+            ui->statusbar->showMessage(tr("%1 rows without a usable id or geometry were skipped").arg(columns.skippedRows));
+        }
+        nodes = std::make_unique<NodeArena>(columns.size());
 
-            nodes.push_back(std::make_unique<GRCylinder>(id, center, direction, 2 * length, radius));
+        for (size_t i = 0; i < columns.size(); ++i) {
+            nodes->addCylinder(columns.ids[i], columns.positions[i], columns.directions[i],
+                               2 * columns.lengths[i], columns.radii[i]);
         }
         break;
     }
     case ParameterModel::Geometry::Cuboidal:
-        break;
     case ParameterModel::Geometry::Spherical:
+        nodes = std::make_unique<NodeArena>(0);
         break;
     }
 
-    return std::move(nodes);
+    return nodes;
 }
 
 void MainWindow::on_generateNodesButton_pressed()
@@ -177,14 +191,18 @@ void MainWindow::on_generateNodesButton_pressed()
     auto nodeScale = ui->nodeScaleSpinBox->value();
     auto spacing = ui->nodeSpacingSpinBox->value();
 
-    for (auto &node : nodes) {
+    for (auto node : nodes->nodes()) {
         node->setNodeScale(nodeScale);
         node->setSpacing(spacing);
     }
 
     auto builder = graphWidget->getBuilder();
 
-    builder->addNodes(std::move(nodes));
+    // only nodes that are new or have moved are tested again on the next build
+    const int rejected = builder->updateNodes(std::move(nodes));
+    if (rejected > 0) {
+        ui->statusbar->showMessage(tr("%1 nodes with a duplicate or invalid id were skipped").arg(rejected));
+    }
 
     graphWidget->clearEvents();
 
@@ -197,8 +215,8 @@ void MainWindow::on_generate2DButton_pressed()
 {
     auto nodes = generateNodes();
 
-    chartWidget->createXY(nodes);
-    chartWidget->createZX(nodes);
+    chartWidget->createXY(nodes->nodes());
+    chartWidget->createZX(nodes->nodes());
 
     ui->tabWidget->setTabEnabled(ui->tabWidget->indexOf(ui->twoDTab), true);
 }
@@ -208,14 +226,8 @@ void MainWindow::on_generate3DModelButton_pressed()
 {
     auto nodes = generateNodes();
 
-    for (auto &node : nodes) {
-        GRCylinder *tmp = dynamic_cast<GRCylinder *>(node.get());
-        if (tmp != nullptr) {
-            std::unique_ptr<GRCylinder> cylinder;
-            node.release();
-            cylinder.reset(tmp);
-            scene->addCylinder(cylinder);
-        }
+    for (size_t i = 0; i < nodes->size(); ++i) {
+        scene->addCylinder(nodes->cylinder(i));
     }
 
     ui->tabWidget->setTabEnabled(ui->tabWidget->indexOf(ui->threeDTab), true);
@@ -257,7 +269,12 @@ void MainWindow::on_actionImport_CSV_triggered()
 
 void MainWindow::on_actionExport_CSV_triggered()
 {
-    auto fileName = QFileDialog::getSaveFileName(this, tr("Export Relation"), lastExportPath, tr("CSV File (*.csv)"));
+    const QString byOrderFilter = tr("CSV File, one row per order (*.csv)");
+    const QString binaryFilter = tr("Binary Relation (*.bin)");
+    QString selectedFilter;
+    auto fileName = QFileDialog::getSaveFileName(this, tr("Export Relation"), lastExportPath,
+                                                 tr("CSV File (*.csv)") + ";;" + byOrderFilter + ";;" + binaryFilter,
+                                                 &selectedFilter);
 
     if (fileName.isEmpty()){
         return;
@@ -267,10 +284,17 @@ void MainWindow::on_actionExport_CSV_triggered()
     QDir dir = info.dir();
     lastExportPath = dir.path();
 
-    GraphWriter writer(graphWidget->getModel()->getNodes());
+    GraphWriter writer(graphWidget->getModel()->getRelation());
+    if (selectedFilter == byOrderFilter) {
+        writer.setLayout(GraphWriter::Layout::ByOrder);
+    }
+
+    const bool binary = selectedFilter == binaryFilter || info.suffix() == "bin";
 
     std::string error;
-    if (!writer.writeCSV(fileName.toStdString(), &error)) {
+    const bool written = binary ? writer.writeBinary(fileName.toStdString(), &error)
+                                : writer.writeCSV(fileName.toStdString(), &error);
+    if (!written) {
 
     }
 }
@@ -352,15 +376,15 @@ void MainWindow::on_actionImport_Event_triggered()
         return;
     }
 
-    DetectionEventReader reader(fileName);
+    auto reader = std::make_unique<DetectionEventReader>();
 
-    bool ok;
-    QVector<DetectionEvent> events = reader.parseEvents(&ok);
-    if (!ok) {
+    QString error;
+    if (!reader->open(fileName, &error)) {
+        QMessageBox::information(this, tr("Unable to open file for reading"), error);
         return;
     }
 
-    graphWidget->addDetectionEvents(events);
+    graphWidget->addDetectionEvents(std::move(reader));
 }
 
 void MainWindow::on_toleranceSpinBox_valueChanged(double value)
@@ -380,3 +404,22 @@ void MainWindow::on_relationOrderSpinBox_valueChanged(int value)
         previousOrder = value;
     }
 }
+
+void MainWindow::on_actionParallel_Build_toggled(bool checked)
+{
+    // partitioned builds are opt-in, the default is a single GRBuilder pass
+    auto builder = graphWidget->getBuilder();
+    builder->setThreadCount(checked ? 0 : 1);
+    if (!builder->isBuilding() && builder->getNodeCount() > 0) {
+        ui->buildButton->setEnabled(true);
+    }
+}
+
+void MainWindow::on_actionSpatial_Grid_toggled(bool checked)
+{
+    auto builder = graphWidget->getBuilder();
+    builder->setUseSpatialGrid(checked);
+    if (!builder->isBuilding() && builder->getNodeCount() > 0) {
+        ui->buildButton->setEnabled(true);
+    }
+}
@@ -0,0 +1,29 @@
+#include "nodearena.h"
+
+using namespace GeomRel;
+
+NodeArena::NodeArena(size_t capacity)
+    : storage(new Storage[capacity]),
+      cap(capacity)
+{
+    nodePtrs.reserve(capacity);
+}
+
+NodeArena::~NodeArena()
+{
+    for (size_t i = 0; i < count; ++i) {
+        cylinder(i).~GRCylinder();
+    }
+}
+
+GRCylinder *NodeArena::addCylinder(int id, const GRVector3 &center, const GRVector3 &direction, double length, double radius)
+{
+    if (count == cap) return nullptr;
+
+    auto cylinder = new (&storage[count]) GRCylinder(id, center, direction, length, radius);
+    ++count;
+
+    nodePtrs.push_back(cylinder);
+
+    return cylinder;
+}
@@ -0,0 +1,216 @@
+#include "nodelayer.h"
+
+#include <QHash>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const QRgb defaultColor = QColor(Qt::white).rgba();
+const QRgb pointColor = QColor(Qt::black).rgba();
+
+// smallest on-screen size at which a node is drawn as an ellipse
+constexpr double minNodePixels = 4;
+
+}
+
+NodeLayer::NodeLayer(const RenderModel *render, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      render(render)
+{
+    // paint only needs to visit the nodes in the exposed rect
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+int NodeLayer::cellCoordinate(double value) const
+{
+    return static_cast<int>(std::floor(value / cellSize));
+}
+
+template <typename F>
+void NodeLayer::forEachNode(const QRectF &rect, F f) const
+{
+    if (cells.empty()) return;
+
+    const double reach = maxExtent * RenderModel::maxScale / 2;
+    const int x0 = cellCoordinate(rect.left() - reach);
+    const int x1 = cellCoordinate(rect.right() + reach);
+    const int y0 = cellCoordinate(rect.top() - reach);
+    const int y1 = cellCoordinate(rect.bottom() + reach);
+
+    // a rect covering more cells than are occupied is cheaper to answer
+    // by visiting every occupied cell
+    if (double(x1 - x0 + 1) * double(y1 - y0 + 1) > cells.size()) {
+        for (const auto &cell : cells) {
+            for (int index : cell.second) f(index);
+        }
+        return;
+    }
+
+    for (int x = x0; x <= x1; ++x) {
+        for (int y = y0; y <= y1; ++y) {
+            auto it = cells.find(cellKey(x, y));
+            if (it == cells.end()) continue;
+
+            for (int index : it->second) f(index);
+        }
+    }
+}
+
+void NodeLayer::addNode(int index, const QRectF &rect)
+{
+    if (contains(index)) removeNode(index);
+
+    if (index >= static_cast<int>(rects.size())) {
+        rects.resize(index + 1);
+    }
+
+    rects[index] = rect;
+
+    // the first node decides the cell size, all nodes of a geometry are
+    // about the same size
+    if (cellSize <= 0) {
+        cellSize = 2 * std::max(rect.width(), rect.height());
+        if (cellSize <= 0) cellSize = 1;
+    }
+
+    const auto center = rect.center();
+    cells[cellKey(cellCoordinate(center.x()), cellCoordinate(center.y()))].push_back(index);
+
+    maxExtent = std::max({maxExtent, rect.width(), rect.height()});
+
+    const double margin = std::max(rect.width(), rect.height()) * (RenderModel::maxScale - 1) / 2 + 1;
+    const auto outer = rect.adjusted(-margin, -margin, margin, margin);
+    if (!bounds.contains(outer)) {
+        prepareGeometryChange();
+        bounds |= outer;
+    }
+    update(outer);
+}
+
+void NodeLayer::removeNode(int index)
+{
+    if (!contains(index)) return;
+
+    const auto rect = scaledRect(index);
+    const auto center = rects[index].center();
+    auto it = cells.find(cellKey(cellCoordinate(center.x()), cellCoordinate(center.y())));
+    if (it != cells.end()) {
+        auto &members = it->second;
+        members.erase(std::find(members.begin(), members.end(), index));
+        if (members.empty()) cells.erase(it);
+    }
+
+    rects[index] = QRectF();
+    update(rect.adjusted(-1, -1, 1, 1));
+}
+
+void NodeLayer::clear()
+{
+    prepareGeometryChange();
+
+    rects.clear();
+    cells.clear();
+
+    bounds = QRectF();
+    maxExtent = 0;
+    cellSize = 0;
+}
+
+bool NodeLayer::collides(int a, int b) const
+{
+    if (!contains(a) || !contains(b)) return false;
+
+    // treat both ellipses as circles of their mean radius
+    const auto &ra = rects[a];
+    const auto &rb = rects[b];
+    const auto d = ra.center() - rb.center();
+    const double reach = (ra.width() + ra.height() + rb.width() + rb.height()) / 4;
+
+    return d.x() * d.x() + d.y() * d.y() < reach * reach;
+}
+
+int NodeLayer::nodeAt(const QPointF &pos) const
+{
+    int found = -1;
+    double closest = 0;
+
+    forEachNode(QRectF(pos, pos), [&](int index) {
+        const auto rect = scaledRect(index);
+        const auto d = pos - rect.center();
+        const double rx = rect.width() / 2;
+        const double ry = rect.height() / 2;
+        if (rx <= 0 || ry <= 0) return;
+
+        const double distance = (d.x() * d.x()) / (rx * rx) + (d.y() * d.y()) / (ry * ry);
+        if (distance <= 1 && (found < 0 || distance < closest)) {
+            found = index;
+            closest = distance;
+        }
+    });
+
+    return found;
+}
+
+QRectF NodeLayer::scaledRect(int index) const
+{
+    const auto &rect = rects[index];
+    const float scale = render->scale(index);
+    if (scale == 1) return rect;
+
+    const auto center = rect.center();
+    const QSizeF size = rect.size() * scale;
+    return QRectF(center.x() - size.width() / 2, center.y() - size.height() / 2,
+                  size.width(), size.height());
+}
+
+void NodeLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+    const double lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    const auto exposed = option->exposedRect;
+
+    if (maxExtent * lod < minNodePixels) {
+        // one batch of points per colour, most nodes share the default one
+        QHash<QRgb, QVector<QPointF>> batches;
+        forEachNode(exposed, [&](int index) {
+            // white nodes are only told apart from the background by their outline
+            const QRgb color = render->color(index);
+            batches[color == defaultColor ? pointColor : color].append(rects[index].center());
+        });
+
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->setBrush(Qt::NoBrush);
+        for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+            // cosmetic pen, points stay two pixels wide at any zoom
+            QPen pen(QColor::fromRgba(it.key()), 2);
+            pen.setCosmetic(true);
+            painter->setPen(pen);
+            painter->drawPoints(it.value().constData(), it.value().size());
+        }
+        return;
+    }
+
+    // one batch of ellipses per fill and outline, so the painter state
+    // changes once per style instead of once per node
+    QHash<quint64, QVector<QRectF>> batches;
+    forEachNode(exposed, [&](int index) {
+        const auto rect = scaledRect(index);
+        if (!rect.intersects(exposed)) return;
+
+        batches[(quint64(render->color(index)) << 32) | render->outline(index)].append(rect);
+    });
+
+    for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+        const QColor color = QColor::fromRgba(QRgb(it.key() >> 32));
+        const QColor outline = QColor::fromRgba(QRgb(it.key() & 0xffffffff));
+
+        painter->setBrush(color);
+        painter->setPen(outline.alpha() ? QPen(outline) : QPen(Qt::NoPen));
+        for (const auto &rect : it.value()) {
+            painter->drawEllipse(rect);
+        }
+    }
+}
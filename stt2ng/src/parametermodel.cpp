@@ -5,16 +5,92 @@
 #include <QJsonObject>
 #include <QMetaEnum>
 
-#include "csvreader.h"
 #include "geometryparameter.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
 
 ParameterModel::ParameterModel(QObject *parent)
-    : QStandardItemModel(parent)
+    : QAbstractTableModel(parent)
 {
     createGeometryParameters();
 }
 
+int ParameterModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : table.rowCount();
+}
+
+int ParameterModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : table.columnCount();
+}
+
+QVariant ParameterModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) return {};
+
+    if (role == Qt::DisplayRole || role == Qt::EditRole) {
+        // cell text is decoded on demand, only for the cells the view asks for
+        return table.text(index.row(), index.column());
+    }
+    return {};
+}
+
+CylinderColumns ParameterModel::resolveCylinders(int firstRow) const
+{
+    CylinderColumns columns;
+
+    const auto cylinderParameters = parameters.value(Cylindrical);
+    const int rows = table.rowCount();
+    if (cylinderParameters.isEmpty() || firstRow >= rows) return columns;
+
+    // resolve each field to a span once, instead of per cell
+    const auto id = cylinderParameters.value("ID")->toSpan();
+    const auto posX = cylinderParameters.value("Position")->toSpan("X");
+    const auto posY = cylinderParameters.value("Position")->toSpan("Y");
+    const auto posZ = cylinderParameters.value("Position")->toSpan("Z");
+    const auto dirX = cylinderParameters.value("Direction")->toSpan("X");
+    const auto dirY = cylinderParameters.value("Direction")->toSpan("Y");
+    const auto dirZ = cylinderParameters.value("Direction")->toSpan("Z");
+    const auto radius = cylinderParameters.value("Radius")->toSpan();
+    const auto length = cylinderParameters.value("Length")->toSpan();
+
+    const int count = rows - firstRow;
+    columns.ids.reserve(count);
+    columns.positions.reserve(count);
+    columns.directions.reserve(count);
+    columns.radii.reserve(count);
+    columns.lengths.reserve(count);
+
+    for (int row = firstRow; row < rows; ++row) {
+        // rows without a usable id or geometry, e.g. a blank cell or a
+        // column outside the table, cannot become nodes
+        const double rowId = id[row];
+        const double values[] = {posX[row], posY[row], posZ[row], dirX[row], dirY[row], dirZ[row],
+                                 radius[row], length[row]};
+        const bool finite = std::all_of(std::begin(values), std::end(values), [](double value) {
+            return std::isfinite(value);
+        });
+        if (!finite || !std::isfinite(rowId) || rowId < std::numeric_limits<int>::min()
+            || rowId > std::numeric_limits<int>::max()) {
+            ++columns.skippedRows;
+            continue;
+        }
+
+        columns.ids.push_back(static_cast<int>(rowId));
+        columns.positions.push_back({values[0], values[1], values[2]});
+        columns.directions.push_back({values[3], values[4], values[5]});
+        columns.radii.push_back(values[6]);
+        columns.lengths.push_back(values[7]);
+    }
+
+    return columns;
+}
+
 ParameterModel::ParseResult ParameterModel::loadDescription(QFile &file)
 {
     ParameterModel::ParseResult result;
@@ -37,13 +113,12 @@ ParameterModel::ParseResult ParameterModel::loadDescription(QFile &file)
         auto csvPath = dir.absoluteFilePath(relativeCsvPath);
         QFile csvFile(csvPath);
 
-        if (!csvFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QString error;
+        if (!loadCSV(csvFile, &error)) {
             result.type = ParameterModel::ParseResult::CsvError;
-            result.error = "The parameter configuration could not be applied, perhaps the corresponding CSV file was moved?\n" + csvFile.errorString();
+            result.error = "The parameter configuration could not be applied, perhaps the corresponding CSV file was moved?\n" + error;
             return result;
         }
-
-        loadCSV(csvFile);
     }
     file.close();
 
@@ -131,16 +206,23 @@ void ParameterModel::saveDescription(QFile &file)
     file.close();
 }
 
-void ParameterModel::loadCSV(QFile &file)
+bool ParameterModel::loadCSV(QFile &file, QString *error)
 {
-    if (populated) {
-        clear();
+    if (file.isOpen()) {
+        file.close();
     }
 
-    CSVReader::populateModel(file, this);
-    setPopulated(true);
+    beginResetModel();
+    bool ok = table.open(file.fileName(), error);
+    endResetModel();
+
+    setPopulated(ok);
+
+    if (ok) {
+        currentCSV = QFileInfo(file).path();
+    }
 
-    currentCSV = QFileInfo(file).path();
+    return ok;
 }
 
 void ParameterModel::addParameters(ParameterModel::Geometry geometry, QVector<GeometryParameter *> parameters)
@@ -0,0 +1,150 @@
+#include "relation.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+
+namespace {
+
+// rows are searched in chunks, so that only one chunk of unmerged rows is
+// held in memory next to the relation itself
+constexpr int rowsPerChunk = 4096;
+
+}
+
+Relation Relation::fromFirstOrder(const std::vector<std::int32_t> &ids,
+                                  const std::vector<std::pair<int, int>> &pairs,
+                                  int maxOrder, int threads,
+                                  const std::atomic<bool> *cancelled,
+                                  const RowSink &sink)
+{
+    Relation relation;
+    relation.maxOrder = std::clamp(maxOrder, 1, maxSupportedOrder);
+    relation.ids = ids;
+
+    const int count = static_cast<int>(ids.size());
+
+    // first-order graph; rows come out sorted because the pairs are
+    std::vector<std::uint64_t> adjOffsets(count + 1, 0);
+    for (auto [from, to] : pairs) {
+        ++adjOffsets[from + 1];
+        ++adjOffsets[to + 1];
+    }
+    for (int i = 0; i < count; ++i) {
+        adjOffsets[i + 1] += adjOffsets[i];
+    }
+
+    std::vector<std::int32_t> adjacent(adjOffsets[count]);
+    std::vector<std::uint64_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+    for (auto [from, to] : pairs) {
+        adjacent[fill[from]++] = to;
+        adjacent[fill[to]++] = from;
+    }
+
+    if (relation.maxOrder == 1 && sink) {
+        std::vector<std::uint8_t> ones;
+        for (int row = 0; row < count; ++row) {
+            const auto degree = adjOffsets[row + 1] - adjOffsets[row];
+            if (ones.size() < degree) ones.resize(degree, 1);
+            sink(row, adjacent.data() + adjOffsets[row], ones.data(), degree);
+        }
+        return relation;
+    }
+
+    if (relation.maxOrder == 1) {
+        relation.offsets = std::move(adjOffsets);
+        relation.neighbours = std::move(adjacent);
+        relation.orders.assign(relation.neighbours.size(), 1);
+        return relation;
+    }
+
+    const int workerCount = Parallel::resolveThreadCount(threads);
+
+    // per worker: the last source that reached each node, so the marks never
+    // have to be cleared between searches
+    std::vector<std::vector<int>> reachedBy(workerCount, std::vector<int>(count, -1));
+
+    relation.offsets.reserve(count + 1);
+
+    std::vector<std::vector<std::int32_t>> rowNodes(rowsPerChunk);
+    std::vector<std::vector<std::uint8_t>> rowOrders(rowsPerChunk);
+
+    for (int chunk = 0; chunk < count; chunk += rowsPerChunk) {
+        if (cancelled && *cancelled) break;
+
+        const int chunkSize = std::min(rowsPerChunk, count - chunk);
+
+        Parallel::forEach(chunkSize, workerCount, [&](size_t i, int worker) {
+            const int source = chunk + static_cast<int>(i);
+            auto &reached = reachedBy[worker];
+            auto &nodes = rowNodes[i];
+            auto &orders = rowOrders[i];
+            nodes.clear();
+            orders.clear();
+
+            reached[source] = source;
+
+            // the previous level of the search is the tail of the row
+            size_t levelBegin = 0;
+            nodes.push_back(source);
+            orders.push_back(0);
+            for (int order = 1; order <= relation.maxOrder; ++order) {
+                const size_t levelEnd = nodes.size();
+
+                for (size_t k = levelBegin; k < levelEnd; ++k) {
+                    const int current = nodes[k];
+                    for (auto e = adjOffsets[current]; e < adjOffsets[current + 1]; ++e) {
+                        const int next = adjacent[e];
+                        if (reached[next] != source) {
+                            reached[next] = source;
+                            nodes.push_back(next);
+                        }
+                    }
+                }
+
+                if (nodes.size() == levelEnd) break;
+
+                std::sort(nodes.begin() + levelEnd, nodes.end());
+                orders.resize(nodes.size(), static_cast<std::uint8_t>(order));
+                levelBegin = levelEnd;
+            }
+
+            // drop the source itself
+            nodes.erase(nodes.begin());
+            orders.erase(orders.begin());
+        });
+
+        if (sink) {
+            for (int i = 0; i < chunkSize; ++i) {
+                sink(chunk + i, rowNodes[i].data(), rowOrders[i].data(), rowNodes[i].size());
+            }
+            continue;
+        }
+
+        for (int i = 0; i < chunkSize; ++i) {
+            relation.neighbours.insert(relation.neighbours.end(), rowNodes[i].begin(), rowNodes[i].end());
+            relation.orders.insert(relation.orders.end(), rowOrders[i].begin(), rowOrders[i].end());
+            relation.offsets.push_back(relation.neighbours.size());
+        }
+    }
+
+    return relation;
+}
+
+Relation Relation::upToOrder(int order) const
+{
+    Relation relation;
+    relation.maxOrder = std::min(order, maxOrder);
+    relation.ids = ids;
+    relation.offsets.reserve(offsets.size());
+
+    for (int row = 0; row < size(); ++row) {
+        const auto begin = rowBegin(row);
+        const auto end = rowEnd(row, order);
+        relation.neighbours.insert(relation.neighbours.end(), neighbours.begin() + begin, neighbours.begin() + end);
+        relation.orders.insert(relation.orders.end(), orders.begin() + begin, orders.begin() + end);
+        relation.offsets.push_back(relation.neighbours.size());
+    }
+
+    return relation;
+}
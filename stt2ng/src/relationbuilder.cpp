@@ -0,0 +1,608 @@
+#include "relationbuilder.h"
+
+#include "nodearena.h"
+#include "parallel.h"
+
+#include <GRBuilder>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+using namespace GeomRel;
+
+namespace {
+
+// number of blocks per thread, so that uneven blocks still balance out
+constexpr int blocksPerThread = 4;
+
+// beyond this share of changed nodes, updateNodes leaves it to a full build
+constexpr int maxChangedShare = 8;
+
+// private copy of a cylinder for a GRBuilder of its own, with the scale and
+// spacing the original was given, which GRBuilder takes into account
+GRCylinder *copyCylinder(NodeArena &arena, const GRCylinder *cylinder)
+{
+    auto copy = arena.addCylinder(cylinder->id(), cylinder->center, cylinder->direction,
+                                  cylinder->length, cylinder->radius);
+    copy->setNodeScale(cylinder->nodeScale());
+    copy->setSpacing(cylinder->spacing());
+    return copy;
+}
+
+}
+
+void RelationBuilder::setNodes(const std::vector<GRNode *> &nodes)
+{
+    this->nodes = nodes;
+
+    ids.clear();
+    retainedPairs.clear();
+    hasRetained = false;
+    pendingNodes.clear();
+    cylinders.clear();
+    bounds.clear();
+    indexOf.clear();
+    maxRadius = 0;
+
+    ids.reserve(nodes.size());
+    indexOf.reserve(nodes.size());
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i) {
+        ids.push_back(nodes[i]->id());
+        indexOf.emplace(nodes[i]->id(), i);
+    }
+
+    // results are reported by id, so ids have to be unique to be mapped back
+    if (indexOf.size() != nodes.size()) return;
+
+    cylinders.reserve(nodes.size());
+    bounds.reserve(nodes.size());
+    for (auto node : nodes) {
+        auto cylinder = dynamic_cast<const GRCylinder *>(node);
+        if (!cylinder) {
+            cylinders.clear();
+            bounds.clear();
+            return;
+        }
+
+        const double direction[3] = {cylinder->direction.x(), cylinder->direction.y(), cylinder->direction.z()};
+        const double center[3] = {cylinder->center.x(), cylinder->center.y(), cylinder->center.z()};
+        const double norm = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        const double halfLength = cylinder->length / 2;
+
+        // how GRBuilder applies scale and spacing is not documented, so the
+        // box grows by both: a larger box only adds candidates, never loses one
+        const double scale = std::max(1.0, cylinder->nodeScale());
+        const double spacing = std::max(0.0, cylinder->spacing());
+
+        SpatialGrid::Box box;
+        bool finite = true;
+        for (int axis = 0; axis < 3; ++axis) {
+            const double extent = ((norm > 0 ? std::abs(direction[axis]) / norm : 1.0) * halfLength + cylinder->radius) * scale
+                                  + spacing;
+            box.min[axis] = center[axis] - extent;
+            box.max[axis] = center[axis] + extent;
+            finite = finite && std::isfinite(box.min[axis]) && std::isfinite(box.max[axis]);
+        }
+
+        // a node without finite bounds cannot be placed in a block or cell
+        if (!finite) {
+            cylinders.clear();
+            bounds.clear();
+            return;
+        }
+
+        cylinders.push_back(cylinder);
+        bounds.push_back(box);
+        maxRadius = std::max(maxRadius, cylinder->radius * scale + spacing);
+    }
+}
+
+void RelationBuilder::updateNodes(const std::vector<GRNode *> &nodes, const std::vector<int> &changedIds)
+{
+    if (!hasRetained) {
+        setNodes(nodes);
+        return;
+    }
+
+    std::vector<std::pair<int, int>> previous;
+    previous.reserve(retainedPairs.size());
+    for (auto [from, to] : retainedPairs) {
+        previous.emplace_back(ids[from], ids[to]);
+    }
+    const double tolerance = retainedTolerance;
+
+    // nodes still waiting for a build since an earlier update stay changed
+    std::vector<int> pendingIds;
+    for (int i : pendingNodes) {
+        pendingIds.push_back(ids[i]);
+    }
+
+    setNodes(nodes);
+    if (!canPartition()) return;
+
+    const int count = static_cast<int>(nodes.size());
+
+    std::vector<char> changed(count, 0);
+    int changedCount = 0;
+    auto mark = [&](int id) {
+        auto it = indexOf.find(id);
+        if (it != indexOf.end() && !changed[it->second]) {
+            changed[it->second] = 1;
+            ++changedCount;
+        }
+    };
+    for (int id : changedIds) mark(id);
+    for (int id : pendingIds) mark(id);
+
+    if (changedCount * maxChangedShare > count) return;
+
+    std::vector<std::pair<int, int>> pairs;
+    pairs.reserve(previous.size());
+    for (auto [from, to] : previous) {
+        auto itFrom = indexOf.find(from);
+        auto itTo = indexOf.find(to);
+        if (itFrom == indexOf.end() || itTo == indexOf.end()) continue;
+        if (changed[itFrom->second] || changed[itTo->second]) continue;
+
+        pairs.emplace_back(std::min(itFrom->second, itTo->second), std::max(itFrom->second, itTo->second));
+    }
+
+    // changed nodes are tested by the next build, on the worker threads
+    retainedPairs = std::move(pairs);
+    retainedTolerance = tolerance;
+    hasRetained = true;
+
+    for (int i = 0; i < count; ++i) {
+        if (changed[i]) pendingNodes.push_back(i);
+    }
+}
+
+bool RelationBuilder::repairRetained(const std::function<void(size_t)> &progress)
+{
+    // only nodes near a changed one can have gained it as a neighbour
+    SpatialGrid grid;
+    grid.build(bounds, searchMargin(retainedTolerance));
+
+    std::vector<char> changed(nodes.size(), 0);
+    for (int i : pendingNodes) changed[i] = 1;
+
+    // pairs of two changed nodes are tested once
+    std::vector<std::pair<int, int>> candidates;
+    for (int i : pendingNodes) {
+        grid.forEachNear(bounds[i], [&](int j) {
+            if (j == i || (changed[j] && j < i)) return;
+            candidates.emplace_back(std::min(i, j), std::max(i, j));
+        });
+    }
+
+    const auto keep = testPairs(candidates, retainedTolerance, progress);
+    if (cancelled) return false;
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (keep[i]) retainedPairs.push_back(candidates[i]);
+    }
+    std::sort(retainedPairs.begin(), retainedPairs.end());
+    retainedPairs.erase(std::unique(retainedPairs.begin(), retainedPairs.end()), retainedPairs.end());
+
+    pendingNodes.clear();
+    return true;
+}
+
+void RelationBuilder::build(int order, double tolerance, ProgressCallback progressCallback, EdgeCallback edgeCallback)
+{
+    const auto relation = buildRelation(order, tolerance, progressCallback);
+
+    // report each pair once, from the row with the smaller index
+    for (int row = 0; row < relation.size(); ++row) {
+        for (auto k = relation.rowBegin(row); k < relation.rowEnd(row); ++k) {
+            const int other = relation.neighbours[k];
+            if (other < row) continue;
+
+            const int ord = relation.orders[k];
+            nodes[row]->addNeighbour(nodes[other]->id(), ord);
+            nodes[other]->addNeighbour(nodes[row]->id(), ord);
+            edgeCallback(nodes[row]->id(), nodes[other]->id(), ord);
+        }
+    }
+}
+
+Relation RelationBuilder::buildRelation(int order, double tolerance, ProgressCallback progressCallback)
+{
+    return buildRows(order, tolerance, progressCallback, nullptr);
+}
+
+bool RelationBuilder::streamRelation(int order, double tolerance, const Relation::RowSink &sink,
+                                     ProgressCallback progressCallback)
+{
+    buildRows(order, tolerance, progressCallback, sink);
+    return !cancelled;
+}
+
+Relation RelationBuilder::buildRows(int order, double tolerance, ProgressCallback progressCallback,
+                                    const Relation::RowSink &sink)
+{
+    // one step per node for the first order, then one per order
+    size_t reported = 0;
+    auto report = [&](size_t done) {
+        for (; reported < done; ++reported) {
+            progressCallback();
+        }
+    };
+
+    // Pairs of the last build at the same tolerance are reused as they are.
+    // Anything else reuses them only in a partitioned build, which already
+    // relies on the estimated search margin; the single pass stays exact.
+    const bool unchanged = hasRetained && pendingNodes.empty() && tolerance == retainedTolerance;
+    const bool reuse = unchanged || (hasRetained && partitioned());
+
+    if (reuse && !pendingNodes.empty() && !repairRetained(report)) return {};
+
+    auto pairs = reuse ? rebuildFirstOrder(tolerance, report)
+                       : buildFirstOrder(tolerance, report);
+    if (cancelled) return {};
+
+    retainedPairs = pairs;
+    retainedTolerance = tolerance;
+    hasRetained = true;
+    pendingNodes.clear();
+
+    auto relation = Relation::fromFirstOrder(ids, pairs, order, threads, &cancelled, sink);
+    if (cancelled) return {};
+
+    report(nodes.size() + order);
+
+    return relation;
+}
+
+RelationBuilder::PartitionCheck RelationBuilder::checkPartitions(double tolerance)
+{
+    PartitionCheck check;
+
+    const int savedThreads = threads;
+    const bool savedGrid = useGrid;
+    auto none = [](size_t) {};
+
+    auto compare = [](const std::vector<std::pair<int, int>> &serial, const std::vector<std::pair<int, int>> &other,
+                      std::size_t *missing, std::size_t *extra) {
+        std::vector<std::pair<int, int>> difference;
+        std::set_difference(serial.begin(), serial.end(), other.begin(), other.end(), std::back_inserter(difference));
+        *missing = difference.size();
+        difference.clear();
+        std::set_difference(other.begin(), other.end(), serial.begin(), serial.end(), std::back_inserter(difference));
+        *extra = difference.size();
+    };
+
+    threads = 1;
+    useGrid = false;
+    const auto serial = buildFirstOrder(tolerance, none);
+    check.serialPairs = serial.size();
+
+    if (canPartition()) {
+        threads = std::max(2, Parallel::resolveThreadCount(savedThreads));
+        compare(serial, buildFirstOrder(tolerance, none), &check.slabsMissing, &check.slabsExtra);
+
+        useGrid = true;
+        compare(serial, buildFirstOrder(tolerance, none), &check.gridMissing, &check.gridExtra);
+    }
+
+    threads = savedThreads;
+    useGrid = savedGrid;
+    return check;
+}
+
+bool RelationBuilder::partitioned() const
+{
+    return canPartition() && (useGrid || Parallel::resolveThreadCount(threads) > 1);
+}
+
+std::string RelationBuilder::partitioning(int threads, bool useGrid)
+{
+    if (useGrid) return "grid";
+
+    const int workerCount = Parallel::resolveThreadCount(threads);
+    return workerCount == 1 ? "serial" : "slabs " + std::to_string(workerCount * blocksPerThread);
+}
+
+std::vector<std::pair<int, int>> RelationBuilder::buildFirstOrder(double tolerance, const std::function<void(size_t)> &progress) const
+{
+    if (!partitioned()) {
+        std::vector<std::pair<int, int>> pairs;
+        size_t done = 0;
+
+        GRBuilder builder;
+        builder.setNodes(nodes);
+        builder.build(1, tolerance, [&]() {
+            progress(++done);
+        }, [&](int id, int other, int ord) {
+            if (ord != 1) return;
+            addPair(pairs, id, other);
+        });
+
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+        return pairs;
+    }
+
+    const double margin = searchMargin(tolerance);
+    const auto blocks = useGrid ? partitionGrid(margin)
+                                : partitionSlabs(margin, Parallel::resolveThreadCount(threads) * blocksPerThread);
+
+    return buildBlocks(blocks, tolerance, progress);
+}
+
+std::vector<std::pair<int, int>> RelationBuilder::rebuildFirstOrder(double tolerance,
+                                                                    const std::function<void(size_t)> &progress) const
+{
+    if (tolerance == retainedTolerance) {
+        progress(nodes.size());
+        return retainedPairs;
+    }
+
+    std::vector<std::pair<int, int>> pairs;
+
+    if (tolerance < retainedTolerance) {
+        // only retained pairs can still be neighbours
+        const auto keep = testPairs(retainedPairs, tolerance, progress);
+        for (size_t i = 0; i < retainedPairs.size(); ++i) {
+            if (keep[i]) pairs.push_back(retainedPairs[i]);
+        }
+        return pairs;
+    }
+
+    // retained pairs stay neighbours, nearby pairs are tested
+    SpatialGrid grid;
+    grid.build(bounds, searchMargin(tolerance));
+
+    std::vector<std::pair<int, int>> candidates;
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i) {
+        grid.forEachNear(bounds[i], [&](int j) {
+            if (j <= i) return;
+
+            const std::pair<int, int> pair(i, j);
+            if (!std::binary_search(retainedPairs.begin(), retainedPairs.end(), pair)) {
+                candidates.push_back(pair);
+            }
+        });
+    }
+
+    const auto keep = testPairs(candidates, tolerance, progress);
+
+    pairs = retainedPairs;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (keep[i]) pairs.push_back(candidates[i]);
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    return pairs;
+}
+
+std::vector<char> RelationBuilder::testPairs(const std::vector<std::pair<int, int>> &pairs, double tolerance,
+                                             const std::function<void(size_t)> &progress) const
+{
+    std::vector<char> neighbours(pairs.size(), 0);
+    std::atomic<size_t> pairsDone {0};
+
+    // pairs are tested in chunks, so progress stays in steps of nodes
+    constexpr size_t pairsPerChunk = 256;
+    const size_t chunks = (pairs.size() + pairsPerChunk - 1) / pairsPerChunk;
+
+    Parallel::forEach(chunks, threads, [&](size_t chunk, int) {
+        if (cancelled) return;
+
+        const size_t begin = chunk * pairsPerChunk;
+        const size_t end = std::min(pairs.size(), begin + pairsPerChunk);
+
+        // one allocation for the copies of the whole chunk
+        NodeArena local(2 * (end - begin));
+        std::vector<GRNode *> pairNodes(2);
+        for (size_t i = begin; i < end; ++i) {
+            pairNodes[0] = copyCylinder(local, cylinders[pairs[i].first]);
+            pairNodes[1] = copyCylinder(local, cylinders[pairs[i].second]);
+
+            GRBuilder builder;
+            builder.setNodes(pairNodes);
+            builder.build(1, tolerance, [](){}, [&](int, int, int ord) {
+                if (ord == 1) neighbours[i] = 1;
+            });
+        }
+
+        pairsDone += end - begin;
+    }, [&](size_t) {
+        if (!pairs.empty()) {
+            progress(pairsDone.load() * nodes.size() / pairs.size());
+        }
+    });
+
+    progress(nodes.size());
+    return neighbours;
+}
+
+void RelationBuilder::addPair(std::vector<std::pair<int, int>> &pairs, int id, int other) const
+{
+    auto from = indexOf.find(id);
+    auto to = indexOf.find(other);
+    if (from == indexOf.end() || to == indexOf.end() || from->second == to->second) return;
+
+    pairs.emplace_back(std::min(from->second, to->second), std::max(from->second, to->second));
+}
+
+double RelationBuilder::searchMargin(double tolerance) const
+{
+    // GRBuilder does not expose its proximity criterion, so this is a guess
+    // meant to hold both if the tolerance is an absolute gap and if it scales
+    // the diameter; checkPartitions tests it on a given geometry
+    return tolerance * std::max(1.0, 2 * maxRadius);
+}
+
+std::vector<RelationBuilder::Block> RelationBuilder::partitionSlabs(double margin, int count) const
+{
+    const int nodeCount = static_cast<int>(nodes.size());
+    count = std::max(1, std::min(count, nodeCount));
+
+    auto center = [this](int node, int axis) {
+        return (bounds[node].min[axis] + bounds[node].max[axis]) / 2;
+    };
+
+    // split along the axis where the nodes are spread widest relative to
+    // their own size, e.g. across long tubes rather than along them
+    int axis = 0;
+    double bestScore = -1;
+    for (int a = 0; a < 3; ++a) {
+        double lo = center(0, a);
+        double hi = lo;
+        double extent = 0;
+        for (int i = 0; i < nodeCount; ++i) {
+            lo = std::min(lo, center(i, a));
+            hi = std::max(hi, center(i, a));
+            extent += bounds[i].max[a] - bounds[i].min[a];
+        }
+
+        const double score = (hi - lo) / (extent / nodeCount + margin);
+        if (score > bestScore) {
+            bestScore = score;
+            axis = a;
+        }
+    }
+
+    std::vector<int> sorted(nodeCount);
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::stable_sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+        return center(a, axis) < center(b, axis);
+    });
+
+    std::vector<double> centers(nodeCount);
+    double maxExtent = 0;
+    for (int i = 0; i < nodeCount; ++i) {
+        centers[i] = center(sorted[i], axis);
+        maxExtent = std::max(maxExtent, (bounds[sorted[i]].max[axis] - bounds[sorted[i]].min[axis]) / 2);
+    }
+
+    std::vector<Block> blocks(count);
+    for (int b = 0; b < count; ++b) {
+        auto &block = blocks[b];
+        const int first = static_cast<int>(static_cast<long long>(nodeCount) * b / count);
+        const int last = static_cast<int>(static_cast<long long>(nodeCount) * (b + 1) / count);
+
+        double lo = bounds[sorted[first]].min[axis];
+        double hi = bounds[sorted[first]].max[axis];
+        for (int i = first; i < last; ++i) {
+            block.owned.push_back(sorted[i]);
+            lo = std::min(lo, bounds[sorted[i]].min[axis]);
+            hi = std::max(hi, bounds[sorted[i]].max[axis]);
+        }
+
+        // any node whose box reaches into the slab widened by the margin
+        auto begin = std::lower_bound(centers.begin(), centers.end(), lo - margin - maxExtent);
+        auto end = std::upper_bound(centers.begin(), centers.end(), hi + margin + maxExtent);
+        for (auto it = begin; it != end; ++it) {
+            const int node = sorted[it - centers.begin()];
+            if (bounds[node].max[axis] >= lo - margin && bounds[node].min[axis] <= hi + margin) {
+                block.candidates.push_back(node);
+            }
+        }
+        std::sort(block.candidates.begin(), block.candidates.end());
+    }
+
+    return blocks;
+}
+
+std::vector<RelationBuilder::Block> RelationBuilder::partitionGrid(double margin) const
+{
+    SpatialGrid grid;
+    grid.build(bounds, margin);
+
+    const auto &members = grid.members();
+
+    std::vector<Block> blocks;
+    blocks.reserve(grid.cells().size());
+
+    for (const auto &cell : grid.cells()) {
+        Block block;
+        SpatialGrid::Box box = bounds[members[cell.first]];
+
+        for (int i = cell.first; i < cell.last; ++i) {
+            const int node = members[i];
+            block.owned.push_back(node);
+
+            for (int axis = 0; axis < 3; ++axis) {
+                box.min[axis] = std::min(box.min[axis], bounds[node].min[axis]);
+                box.max[axis] = std::max(box.max[axis], bounds[node].max[axis]);
+            }
+        }
+
+        // only nodes in this and the adjacent cells are candidates
+        grid.forEachNear(box, [&](int node) {
+            block.candidates.push_back(node);
+        });
+        std::sort(block.candidates.begin(), block.candidates.end());
+
+        blocks.push_back(std::move(block));
+    }
+
+    return blocks;
+}
+
+std::vector<std::pair<int, int>> RelationBuilder::buildBlocks(const std::vector<Block> &blocks, double tolerance,
+                                                              const std::function<void(size_t)> &progress) const
+{
+    std::vector<int> owner(nodes.size(), -1);
+    for (int b = 0; b < static_cast<int>(blocks.size()); ++b) {
+        for (int node : blocks[b].owned) {
+            owner[node] = b;
+        }
+    }
+
+    std::vector<std::vector<std::pair<int, int>>> results(blocks.size());
+    std::atomic<size_t> nodesDone {0};
+
+    Parallel::forEach(blocks.size(), threads, [&](size_t b, int) {
+        if (cancelled) return;
+
+        const auto &block = blocks[b];
+
+        // GRBuilder records neighbours on the nodes it is given, so each
+        // block works on its own copies
+        NodeArena local(block.candidates.size());
+        for (int node : block.candidates) {
+            copyCylinder(local, cylinders[node]);
+        }
+
+        auto &pairs = results[b];
+
+        GRBuilder builder;
+        builder.setNodes(local.nodes());
+        builder.build(1, tolerance, [](){}, [&](int id, int other, int ord) {
+            if (ord != 1) return;
+
+            // a pair is found by every block holding both nodes, keep it
+            // only in the block owning its first node
+            const int from = std::min(indexOf.at(id), indexOf.at(other));
+            if (owner[from] == static_cast<int>(b)) {
+                addPair(pairs, id, other);
+            }
+        });
+
+        nodesDone += block.owned.size();
+    }, [&](size_t) {
+        progress(nodesDone.load());
+    });
+
+    size_t total = 0;
+    for (const auto &pairs : results) {
+        total += pairs.size();
+    }
+
+    std::vector<std::pair<int, int>> merged;
+    merged.reserve(total);
+    for (const auto &pairs : results) {
+        merged.insert(merged.end(), pairs.begin(), pairs.end());
+    }
+
+    std::sort(merged.begin(), merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+
+    return merged;
+}
@@ -0,0 +1,129 @@
+#include "relationcache.h"
+
+#include "graphwriter.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+
+bool addFile(QCryptographicHash &hash, const QString &path, QByteArray *contents = nullptr)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    // the size separates the inputs, so their bytes cannot run into each other
+    hash.addData(QByteArray::number(file.size()));
+    hash.addData("\n", 1);
+
+    if (contents) {
+        *contents = file.readAll();
+        hash.addData(*contents);
+        return true;
+    }
+
+    return hash.addData(&file);
+}
+
+}
+
+RelationCache::RelationCache(const QString &directory)
+    : directory(directory)
+{}
+
+QByteArray RelationCache::key(const QString &descriptionPath, int order, double tolerance,
+                              const std::string &partitioning, QString *error)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+
+    // changing the file format invalidates all entries
+    hash.addData("STT2NG relation ");
+    hash.addData(QByteArray::number(RelationFile::version));
+    hash.addData("\n", 1);
+
+    QByteArray description;
+    if (!addFile(hash, descriptionPath, &description)) {
+        if (error) *error = QStringLiteral("Unable to read %1.").arg(descriptionPath);
+        return {};
+    }
+
+    const auto root = QJsonDocument::fromJson(description).object();
+    if (root.contains("CSV")) {
+        const QDir dir = QFileInfo(descriptionPath).dir();
+        const auto csvPath = dir.absoluteFilePath(root.value("CSV").toString());
+        if (!addFile(hash, csvPath)) {
+            if (error) *error = QStringLiteral("Unable to read %1.").arg(csvPath);
+            return {};
+        }
+    }
+
+    hash.addData(QByteArray::number(order));
+    hash.addData("\n", 1);
+    hash.addData(QByteArray::number(tolerance, 'g', 17));
+    hash.addData("\n", 1);
+    hash.addData(partitioning.data(), static_cast<int>(partitioning.size()));
+
+    return hash.result().toHex();
+}
+
+QString RelationCache::pathFor(const QByteArray &key) const
+{
+    return QDir(directory).filePath(QString::fromLatin1(key) + ".bin");
+}
+
+bool RelationCache::find(const QByteArray &key, RelationFile *file) const
+{
+    if (key.isEmpty()) return false;
+
+    const auto path = pathFor(key);
+    if (!QFileInfo::exists(path)) return false;
+
+    return file->open(path);
+}
+
+bool RelationCache::store(const QByteArray &key, const Relation &relation, QString *error) const
+{
+    if (key.isEmpty()) return false;
+
+    if (!QDir().mkpath(directory)) {
+        if (error) *error = QStringLiteral("Unable to create cache directory %1.").arg(directory);
+        return false;
+    }
+
+    // a valid entry with the same key holds the same relation and is never
+    // replaced; only one that does not open (e.g. left truncated) is removed
+    const auto path = pathFor(key);
+    if (QFileInfo::exists(path)) {
+        RelationFile existing;
+        if (existing.open(path)) return true;
+        QFile::remove(path);
+    }
+
+    const auto temporary = path + QStringLiteral(".%1.tmp").arg(QCoreApplication::applicationPid());
+
+    GraphWriter writer(relation);
+    std::string writeError;
+    if (!writer.writeBinary(temporary.toStdString(), &writeError)) {
+        QFile::remove(temporary);
+        if (error) *error = QString::fromStdString(writeError);
+        return false;
+    }
+
+    // rename does not overwrite, so an entry another run stored in the
+    // meantime (and may have mapped) is kept as it is
+    if (!QFile::rename(temporary, path)) {
+        QFile::remove(temporary);
+        RelationFile existing;
+        if (existing.open(path)) return true;
+
+        if (error) *error = QStringLiteral("Unable to store %1 in the cache.").arg(path);
+        return false;
+    }
+
+    return true;
+}
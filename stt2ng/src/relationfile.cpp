@@ -0,0 +1,94 @@
+#include "relationfile.h"
+
+#include <cstring>
+#include <limits>
+
+bool RelationFile::open(const QString &path, QString *error)
+{
+    close();
+
+    auto fail = [&](const QString &message) {
+        if (error) *error = message;
+        close();
+        return false;
+    };
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QStringLiteral("Unable to open %1 for reading.").arg(path));
+    }
+
+    const auto size = static_cast<std::uint64_t>(file.size());
+    if (size < sizeof(Header)) {
+        return fail(QStringLiteral("%1 is not a relation file.").arg(path));
+    }
+
+    data = file.map(0, file.size());
+    if (!data) {
+        return fail(QStringLiteral("Unable to map %1.").arg(path));
+    }
+
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        return fail(QStringLiteral("%1 is not a relation file.").arg(path));
+    }
+    if (header.version != version) {
+        return fail(QStringLiteral("%1 has unsupported version %2.").arg(path).arg(header.version));
+    }
+    // counts this large cannot come from a file that fits the size check
+    const auto limit = static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max());
+    if (header.nodeCount > limit || header.edgeCount > size || fileSize(header) != size) {
+        return fail(QStringLiteral("%1 is truncated or corrupt.").arg(path));
+    }
+
+    idArray = reinterpret_cast<const std::int32_t *>(data + idsOffset());
+    offsetArray = reinterpret_cast<const std::uint64_t *>(data + offsetsOffset(header));
+    neighbourArray = reinterpret_cast<const std::int32_t *>(data + neighboursOffset(header));
+    orderArray = reinterpret_cast<const std::uint8_t *>(data + ordersOffset(header));
+
+    // keep every access through the offsets and neighbours inside the mapping
+    if (offsetArray[0] != 0 || offsetArray[header.nodeCount] != header.edgeCount) {
+        return fail(QStringLiteral("%1 is truncated or corrupt.").arg(path));
+    }
+    for (std::uint64_t row = 0; row < header.nodeCount; ++row) {
+        if (offsetArray[row] > offsetArray[row + 1]) {
+            return fail(QStringLiteral("%1 is truncated or corrupt.").arg(path));
+        }
+    }
+    for (std::uint64_t k = 0; k < header.edgeCount; ++k) {
+        if (neighbourArray[k] < 0 || static_cast<std::uint64_t>(neighbourArray[k]) >= header.nodeCount) {
+            return fail(QStringLiteral("%1 is truncated or corrupt.").arg(path));
+        }
+    }
+
+    return true;
+}
+
+void RelationFile::close()
+{
+    if (data) {
+        file.unmap(data);
+        data = nullptr;
+    }
+    file.close();
+
+    header = {};
+    idArray = nullptr;
+    offsetArray = nullptr;
+    neighbourArray = nullptr;
+    orderArray = nullptr;
+}
+
+Relation RelationFile::toRelation() const
+{
+    Relation relation;
+    if (!isOpen()) return relation;
+
+    relation.maxOrder = maxOrder();
+    relation.ids.assign(idArray, idArray + header.nodeCount);
+    relation.offsets.assign(offsetArray, offsetArray + header.nodeCount + 1);
+    relation.neighbours.assign(neighbourArray, neighbourArray + header.edgeCount);
+    relation.orders.assign(orderArray, orderArray + header.edgeCount);
+
+    return relation;
+}
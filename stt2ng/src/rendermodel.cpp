@@ -0,0 +1,304 @@
+#include "rendermodel.h"
+
+#include "hitindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const QRgb defaultColor = QColor(Qt::white).rgba();
+const QRgb defaultOutline = QColor(Qt::black).rgba();
+
+}
+
+RenderModel::RenderModel(GraphModel *model, QObject *parent)
+    : QObject(parent),
+      model(model)
+{
+    connect(model, &GraphModel::nodeAdded, this, &RenderModel::addNode);
+    connect(model, &GraphModel::nodeRemoved, this, &RenderModel::removeNode);
+    connect(model, &GraphModel::edgeAdded, this, &RenderModel::addEdge);
+    connect(model, &GraphModel::edgesAdded, this, &RenderModel::addEdges);
+    connect(model, &GraphModel::edgeRemoved, this, &RenderModel::removeEdge);
+    connect(model, &GraphModel::allNodesRemoved, this, &RenderModel::removeAllNodes);
+    connect(model, &GraphModel::allEdgesRemoved, this, &RenderModel::removeAllEdges);
+    connect(model, &GraphModel::nodeSelected, this, &RenderModel::setSelected);
+}
+
+const std::vector<int> &RenderModel::edgesOf(int index) const
+{
+    static const std::vector<int> none;
+    return index >= 0 && index < static_cast<int>(incident.size()) ? incident[index] : none;
+}
+
+int RenderModel::findEdge(int from, int to) const
+{
+    for (int edge : edgesOf(from)) {
+        if (this->from(edge) == from && this->to(edge) == to) return edge;
+    }
+    return -1;
+}
+
+bool RenderModel::resolve(Trajectory &trajectory) const
+{
+    if (trajectory.getResolvedVersion() == version) return false;
+
+    QVector<int> indices;
+    const int unknown = resolveHits(trajectory.getHits(), indices, [this](int id) { return model->indexOf(id); });
+
+    trajectory.setIndices(indices, unknown, version);
+    return true;
+}
+
+void RenderModel::drawTrajectory(const Trajectory &trajectory, QColor color, double scale)
+{
+    for (int index : trajectory.getIndices()) {
+        if (!contains(index)) continue;
+
+        setColor(index, color);
+        setScale(index, scale);
+    }
+
+    emit styleChanged();
+}
+
+void RenderModel::select(int id)
+{
+    // the model tells every listener, this one included, through nodeSelected
+    const int selected = model->currentSelection();
+    if (id == selected) return;
+
+    if (selected >= 0) model->deselectNode(selected);
+    if (id >= 0) model->selectNode(id);
+}
+
+void RenderModel::addNode(GRNode *node)
+{
+    const int index = model->indexOf(node->id());
+    if (index >= static_cast<int>(present.size())) {
+        present.resize(index + 1, false);
+        colors.resize(index + 1, defaultColor);
+        outlines.resize(index + 1, defaultOutline);
+        scales.resize(index + 1, 1);
+    }
+
+    present[index] = true;
+    colors[index] = defaultColor;
+    outlines[index] = defaultOutline;
+    scales[index] = 1;
+    ++version;
+
+    emit nodeAdded(index);
+}
+
+void RenderModel::removeNode(GRNode *node)
+{
+    const int index = model->indexOf(node->id());
+    if (!contains(index)) return;
+
+    if (currentSelection == node->id()) {
+        hideNeighbours(index);
+        currentSelection = -1;
+        emit styleChanged();
+    }
+
+    present[index] = false;
+    emit nodeRemoved(index);
+}
+
+void RenderModel::removeAllNodes()
+{
+    currentSelection = -1;
+
+    present.clear();
+    colors.clear();
+    outlines.clear();
+    scales.clear();
+    ++version;
+
+    emit allNodesRemoved();
+}
+
+void RenderModel::appendEdge(int from, int to)
+{
+    const int edge = edgeCount();
+    ends.push_back(from);
+    ends.push_back(to);
+
+    const auto count = static_cast<size_t>(std::max(from, to)) + 1;
+    if (incident.size() < count) incident.resize(count);
+    incident[from].push_back(edge);
+    if (to != from) incident[to].push_back(edge);
+}
+
+void RenderModel::addEdge(GRNode *from, GRNode *to, int order)
+{
+    // only direct edges are drawn
+    if (order != 1) return;
+
+    const int v_from = model->indexOf(from->id());
+    const int v_to = model->indexOf(to->id());
+    if (!contains(v_from) || !contains(v_to)) return;
+
+    const int first = edgeCount();
+    appendEdge(v_from, v_to);
+    emit edgesAdded(first);
+}
+
+void RenderModel::addEdges(const std::vector<GraphModel::Edge> &edges)
+{
+    // only direct edges are drawn
+    ends.reserve(ends.size() + 2 * std::count_if(edges.begin(), edges.end(), [](const GraphModel::Edge &edge) {
+        return edge.order == 1;
+    }));
+
+    const int first = edgeCount();
+    for (const auto &edge : edges) {
+        if (edge.order != 1) continue;
+
+        const int v_from = model->indexOf(edge.from);
+        const int v_to = model->indexOf(edge.to);
+        if (!contains(v_from) || !contains(v_to)) continue;
+
+        appendEdge(v_from, v_to);
+    }
+
+    if (edgeCount() > first) emit edgesAdded(first);
+}
+
+void RenderModel::removeEdge(GRNode *from, GRNode *to)
+{
+    const int edge = findEdge(model->indexOf(from->id()), model->indexOf(to->id()));
+    if (edge < 0) return;
+
+    const bool wasShown = std::find(shown.begin(), shown.end(), edge) != shown.end();
+    setShown(edge, false);
+
+    for (int index : {this->from(edge), this->to(edge)}) {
+        auto &edges = incident[index];
+        auto it = std::find(edges.begin(), edges.end(), edge);
+        if (it != edges.end()) edges.erase(it);
+    }
+
+    ends[2 * edge] = -1;
+    ends[2 * edge + 1] = -1;
+
+    if (wasShown) emit styleChanged();
+}
+
+void RenderModel::removeAllEdges()
+{
+    ends.clear();
+    incident.clear();
+    shown.clear();
+
+    emit allEdgesRemoved();
+}
+
+void RenderModel::setSelected(int id, bool selected)
+{
+    const int index = model->indexOf(id);
+    if (!contains(index)) return;
+
+    if (selected) {
+        setColor(index, Qt::green);
+        showNeighbours(index);
+        currentSelection = id;
+    } else {
+        setColor(index, Qt::white);
+        hideNeighbours(index);
+        if (currentSelection == id) currentSelection = -1;
+    }
+
+    emit styleChanged();
+}
+
+void RenderModel::setShown(int edge, bool show)
+{
+    auto it = std::find(shown.begin(), shown.end(), edge);
+    if (show == (it != shown.end())) return;
+
+    if (show) {
+        shown.push_back(edge);
+    } else {
+        shown.erase(it);
+    }
+}
+
+void RenderModel::setColor(int index, const QColor &color)
+{
+    if (contains(index)) colors[index] = color.rgba();
+}
+
+void RenderModel::setOutline(int index, const QColor &color)
+{
+    if (contains(index)) outlines[index] = color.rgba();
+}
+
+void RenderModel::setScale(int index, double scale)
+{
+    if (contains(index)) scales[index] = std::min(scale, maxScale);
+}
+
+void RenderModel::showNeighbours(int index)
+{
+    // show the direct edges
+    for (int edge : edgesOf(index)) {
+        const int other = from(edge) == index ? to(edge) : from(edge);
+
+        setShown(edge, true);
+        setColor(other, Qt::yellow);
+    }
+
+    // rows are sorted by order, so the direct neighbours come first
+    const auto &relation = model->getRelation();
+    auto k = relation.rowBegin(index);
+    const auto end = relation.rowEnd(index);
+    while (k < end && relation.orders[k] == 1) ++k;
+
+    const double arc_phi = 0.618033988749895;
+
+    for (; k < end; ++k) {
+        // color nodes based on order, don't draw edges
+        const int other = relation.neighbours[k];
+
+        double h, s, l;
+        QColor(Qt::green).getHslF(&h, &s, &l);
+
+        for (int j = 0; j < relation.orders[k]; ++j) {
+            h += arc_phi;
+            h = std::fmod(h, 1.0);
+        }
+        auto color = QColor::fromHslF(h, s, l);
+        setColor(other, color);
+        setOutline(other, color.darker(150));
+        setScale(other, 1.15);
+    }
+}
+
+void RenderModel::hideNeighbours(int index)
+{
+    // hide the direct edges
+    for (int edge : edgesOf(index)) {
+        const int other = from(edge) == index ? to(edge) : from(edge);
+
+        setShown(edge, false);
+        setColor(other, Qt::white);
+    }
+
+    // rows are sorted by order, so the direct neighbours come first
+    const auto &relation = model->getRelation();
+    auto k = relation.rowBegin(index);
+    const auto end = relation.rowEnd(index);
+    while (k < end && relation.orders[k] == 1) ++k;
+
+    for (; k < end; ++k) {
+        // set nodes back to default color
+        const int other = relation.neighbours[k];
+
+        setColor(other, Qt::white);
+        setOutline(other, Qt::black);
+        setScale(other, 1.0);
+    }
+}
@@ -0,0 +1,65 @@
+#include "spatialgrid.h"
+
+#include <numeric>
+
+namespace {
+
+// keeps cell keys well within 64 bits for degenerate inputs
+constexpr std::int64_t maxCellsPerAxis = std::int64_t(1) << 20;
+
+}
+
+void SpatialGrid::build(const std::vector<Box> &boxes, double margin)
+{
+    this->boxes = boxes;
+    this->margin = margin;
+
+    sorted.clear();
+    occupied.clear();
+    cellIndex.clear();
+
+    const int count = static_cast<int>(boxes.size());
+    if (count == 0) return;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        double lo = boxes[0].center(axis);
+        double hi = lo;
+        double maxWidth = 0;
+        for (const auto &box : boxes) {
+            lo = std::min(lo, box.center(axis));
+            hi = std::max(hi, box.center(axis));
+            maxWidth = std::max(maxWidth, box.max[axis] - box.min[axis]);
+        }
+
+        origin[axis] = lo;
+        maxHalfWidth[axis] = maxWidth / 2;
+        cellSize[axis] = std::max({maxWidth + margin, (hi - lo) / maxCellsPerAxis, 1e-9});
+        dims[axis] = coordinate(hi, axis) + 1;
+    }
+
+    std::vector<std::int64_t> keys(count);
+    for (int i = 0; i < count; ++i) {
+        std::int64_t coord[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            coord[axis] = coordinate(boxes[i].center(axis), axis);
+        }
+        keys[i] = key(coord);
+    }
+
+    sorted.resize(count);
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::stable_sort(sorted.begin(), sorted.end(), [&](int a, int b) {
+        return keys[a] < keys[b];
+    });
+
+    for (int first = 0; first < count;) {
+        int last = first + 1;
+        while (last < count && keys[sorted[last]] == keys[sorted[first]]) {
+            ++last;
+        }
+
+        cellIndex.emplace(keys[sorted[first]], static_cast<int>(occupied.size()));
+        occupied.push_back({first, last});
+        first = last;
+    }
+}
@@ -17,9 +17,9 @@ ThreeDScene::~ThreeDScene()
 {
 }
 
-void ThreeDScene::addCylinder(const std::unique_ptr<GRCylinder> &cylinder)
+void ThreeDScene::addCylinder(const GRCylinder &cylinder)
 {
-    addCylinder(cylinder->center, cylinder->direction, cylinder->radius, cylinder->length);
+    addCylinder(cylinder.center, cylinder.direction, cylinder.radius, cylinder.length);
 }
 
 void ThreeDScene::addCylinder(const GRVector3 &position, const GRVector3 &direction, double radius, double length)
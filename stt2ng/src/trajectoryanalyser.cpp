@@ -0,0 +1,104 @@
+#include "trajectoryanalyser.h"
+
+#include "parallel.h"
+
+
+std::uint64_t TrajectoryAnalyser::Result::covered(int order) const
+{
+    std::uint64_t count = 0;
+    for (int o = 1; o <= order && o < static_cast<int>(byOrder.size()); ++o) {
+        count += byOrder[o];
+    }
+    return count;
+}
+
+double TrajectoryAnalyser::Result::coverage(int order) const
+{
+    return pairs > 0 ? static_cast<double>(covered(order)) / pairs : 0.0;
+}
+
+void TrajectoryAnalyser::Result::merge(const Result &other)
+{
+    events += other.events;
+    failed += other.failed;
+    pairs += other.pairs;
+    unknown += other.unknown;
+
+    if (byOrder.size() < other.byOrder.size()) {
+        byOrder.resize(other.byOrder.size(), 0);
+    }
+    for (size_t o = 0; o < other.byOrder.size(); ++o) {
+        byOrder[o] += other.byOrder[o];
+    }
+}
+
+TrajectoryAnalyser::TrajectoryAnalyser(const Relation &relation)
+    : relation(relation)
+{
+    for (int row = 0; row < relation.size(); ++row) {
+        if (relation.ids[row] != Relation::removedId) rows.insert(relation.ids[row], row);
+    }
+}
+
+TrajectoryAnalyser::Result TrajectoryAnalyser::analyse(const DetectionEventReader &reader) const
+{
+    const int workerCount = Parallel::resolveThreadCount(threads);
+
+    // per worker, merged in worker order at the end
+    std::vector<Result> results(workerCount);
+    std::vector<DetectionEventReader::Event> events(workerCount);
+
+    Parallel::forEach(reader.eventCount(), workerCount, [&](size_t e, int worker) {
+        auto &event = events[worker];
+        auto &result = results[worker];
+
+        ++result.events;
+        if (!reader.readEvent(static_cast<int>(e), &event)) {
+            ++result.failed;
+            return;
+        }
+
+        event.resolve([this](int id) { return rowOf(id); });
+        analyseEvent(event, &result);
+    });
+
+    Result total;
+    total.byOrder.assign(relation.maxOrder + 1, 0);
+    for (const auto &result : results) {
+        total.merge(result);
+    }
+    return total;
+}
+
+void TrajectoryAnalyser::analyseEvent(const DetectionEventReader::Event &event, Result *result) const
+{
+    if (result->byOrder.size() < static_cast<size_t>(relation.maxOrder + 1)) {
+        result->byOrder.resize(relation.maxOrder + 1, 0);
+    }
+
+    for (int t = 0; t < event.trajectoryCount(); ++t) {
+        for (auto k = event.offsets[t] + 1; k < event.offsets[t + 1]; ++k) {
+            if (event.hits[k - 1] == event.hits[k]) continue;
+
+            ++result->pairs;
+
+            const int from = event.indices[k - 1];
+            const int to = event.indices[k];
+            if (from < 0 || to < 0) {
+                ++result->unknown;
+                continue;
+            }
+
+            ++result->byOrder[orderBetween(from, to)];
+        }
+    }
+}
+
+int TrajectoryAnalyser::orderBetween(int from, int to) const
+{
+    // rows are sorted by order, the first match is the lowest
+    for (auto k = relation.rowBegin(from); k < relation.rowEnd(from); ++k) {
+        if (relation.neighbours[k] == to) return relation.orders[k];
+    }
+    return 0;
+}
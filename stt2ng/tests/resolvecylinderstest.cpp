@@ -0,0 +1,72 @@
+#include "geometryparameter.h"
+#include "parametermodel.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+}
+
+// a row with a blank position cell is skipped and counted, not turned into
+// a node at NaN
+int main()
+{
+    QTemporaryDir dir;
+    check(dir.isValid(), "temporary directory");
+
+    const auto path = dir.filePath("tubes.csv");
+    QFile csv(path);
+    check(csv.open(QIODevice::WriteOnly | QIODevice::Text), "write CSV");
+    csv.write("ID,x,y,z,dx,dy,dz,halflength,radius\n"
+              "1,0,0,0,0,0,1,75,0.5\n"
+              "2,,1,0,0,0,1,75,0.5\n"
+              "3,2,0,0,0,0,1,75,0.5\n");
+    csv.close();
+
+    ParameterModel model;
+    QString error;
+    check(model.loadCSV(csv, &error), "load CSV");
+
+    auto parameters = model.getParametersByGeometry(ParameterModel::Cylindrical);
+    auto bind = [&](const QString &name, const QString &field, int column) {
+        parameters.value(name)->setIsColumnValue(true);
+        parameters.value(name)->setFieldValue(column, field);
+    };
+    bind("ID", nullptr, 0);
+    bind("Position", "X", 1);
+    bind("Position", "Y", 2);
+    bind("Position", "Z", 3);
+    bind("Direction", "X", 4);
+    bind("Direction", "Y", 5);
+    bind("Direction", "Z", 6);
+    bind("Length", nullptr, 7);
+    bind("Radius", nullptr, 8);
+
+    const auto columns = model.resolveCylinders();
+    check(columns.size() == 2, "two usable rows");
+    check(columns.skippedRows == 1, "one skipped row");
+    check(columns.size() == 2 && columns.ids[0] == 1 && columns.ids[1] == 3, "ids of the usable rows");
+    for (const auto &position : columns.positions) {
+        check(std::isfinite(position.x()) && std::isfinite(position.y()) && std::isfinite(position.z()),
+              "finite positions");
+    }
+
+    // the scalar accessors read the blank cell as 0, as before
+    check(parameters.value("Position")->toGRVector3(2).x() == 0, "blank cell reads as 0");
+
+    return failures == 0 ? 0 : 1;
+}